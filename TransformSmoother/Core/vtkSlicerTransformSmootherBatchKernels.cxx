@@ -0,0 +1,345 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherBatchKernels.h"
+
+// STD includes
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define TRANSFORMSMOOTHER_USE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define TRANSFORMSMOOTHER_USE_SSE2
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Coefficients of the series sin(t*theta)/sin(theta) = t * (1 + sum_i prod_k<=i (U[k]*t^2 - V[k]) * (x-1))
+// with x = cos(theta), U[k] = 1/(k(2k+1)) and V[k] = k/(2k+1).
+// The last term is scaled by (1+mu) to compensate for the truncation of the series.
+const int SlerpSeriesLength = 16;
+const double SlerpTruncationCorrection = 1.91668;
+
+struct SlerpSeriesCoefficients
+{
+  SlerpSeriesCoefficients()
+  {
+    for (int i = 0; i < SlerpSeriesLength; ++i)
+      {
+      const double k = i + 1;
+      this->U[i] = 1.0 / ( k * ( 2.0 * k + 1.0 ) );
+      this->V[i] = k / ( 2.0 * k + 1.0 );
+      }
+    this->U[SlerpSeriesLength-1] *= SlerpTruncationCorrection;
+    this->V[SlerpSeriesLength-1] *= SlerpTruncationCorrection;
+  }
+  double U[SlerpSeriesLength];
+  double V[SlerpSeriesLength];
+};
+
+const SlerpSeriesCoefficients SlerpCoefficients;
+
+//----------------------------------------------------------------------------
+// Operations on packs of doubles. The same kernel is instantiated for each instruction set.
+struct ScalarOperations
+{
+  typedef double Pack;
+  enum { Width = 1 };
+  static Pack Load(const double* p) { return *p; }
+  static void Store(double* p, Pack a) { *p = a; }
+  static Pack Set(double a) { return a; }
+  static Pack Add(Pack a, Pack b) { return a + b; }
+  static Pack Sub(Pack a, Pack b) { return a - b; }
+  static Pack Mul(Pack a, Pack b) { return a * b; }
+  static Pack Div(Pack a, Pack b) { return a / b; }
+  static Pack Sqrt(Pack a) { return sqrt( a ); }
+  static Pack Min(Pack a, Pack b) { return a < b ? a : b; }
+  // Sign of a as a factor to apply with ApplySign
+  static Pack Sign(Pack a) { return a < 0.0 ? -1.0 : 1.0; }
+  static Pack Abs(Pack a) { return fabs( a ); }
+  static Pack ApplySign(Pack a, Pack sign) { return a * sign; }
+};
+
+#if defined(TRANSFORMSMOOTHER_USE_SSE2)
+struct SSE2Operations
+{
+  typedef __m128d Pack;
+  enum { Width = 2 };
+  static Pack Load(const double* p) { return _mm_loadu_pd( p ); }
+  static void Store(double* p, Pack a) { _mm_storeu_pd( p, a ); }
+  static Pack Set(double a) { return _mm_set1_pd( a ); }
+  static Pack Add(Pack a, Pack b) { return _mm_add_pd( a, b ); }
+  static Pack Sub(Pack a, Pack b) { return _mm_sub_pd( a, b ); }
+  static Pack Mul(Pack a, Pack b) { return _mm_mul_pd( a, b ); }
+  static Pack Div(Pack a, Pack b) { return _mm_div_pd( a, b ); }
+  static Pack Sqrt(Pack a) { return _mm_sqrt_pd( a ); }
+  static Pack Min(Pack a, Pack b) { return _mm_min_pd( a, b ); }
+  // Sign bit of a, applied with a xor
+  static Pack Sign(Pack a) { return _mm_and_pd( a, _mm_set1_pd( -0.0 ) ); }
+  static Pack Abs(Pack a) { return _mm_andnot_pd( _mm_set1_pd( -0.0 ), a ); }
+  static Pack ApplySign(Pack a, Pack sign) { return _mm_xor_pd( a, sign ); }
+};
+#endif
+
+#if defined(TRANSFORMSMOOTHER_USE_AVX)
+struct AVXOperations
+{
+  typedef __m256d Pack;
+  enum { Width = 4 };
+  static Pack Load(const double* p) { return _mm256_loadu_pd( p ); }
+  static void Store(double* p, Pack a) { _mm256_storeu_pd( p, a ); }
+  static Pack Set(double a) { return _mm256_set1_pd( a ); }
+  static Pack Add(Pack a, Pack b) { return _mm256_add_pd( a, b ); }
+  static Pack Sub(Pack a, Pack b) { return _mm256_sub_pd( a, b ); }
+  static Pack Mul(Pack a, Pack b) { return _mm256_mul_pd( a, b ); }
+  static Pack Div(Pack a, Pack b) { return _mm256_div_pd( a, b ); }
+  static Pack Sqrt(Pack a) { return _mm256_sqrt_pd( a ); }
+  static Pack Min(Pack a, Pack b) { return _mm256_min_pd( a, b ); }
+  // Sign bit of a, applied with a xor
+  static Pack Sign(Pack a) { return _mm256_and_pd( a, _mm256_set1_pd( -0.0 ) ); }
+  static Pack Abs(Pack a) { return _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), a ); }
+  static Pack ApplySign(Pack a, Pack sign) { return _mm256_xor_pd( a, sign ); }
+};
+#endif
+
+//----------------------------------------------------------------------------
+// Polynomial slerp of the quaternion pairs [begin, end) by packs of Ops::Width.
+// Returns the index of the first pair that has not been processed (less than one pack left).
+template <class Ops>
+int PolynomialSlerpPacks(int begin, int end, const double* t,
+               const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+               const double* toW, const double* toX, const double* toY, const double* toZ,
+               double* resultW, double* resultX, double* resultY, double* resultZ)
+{
+  typedef typename Ops::Pack Pack;
+  const Pack one = Ops::Set( 1.0 );
+
+  int i = begin;
+  for (; i + Ops::Width <= end; i += Ops::Width)
+    {
+    const Pack pw = Ops::Load( fromW + i );
+    const Pack px = Ops::Load( fromX + i );
+    const Pack py = Ops::Load( fromY + i );
+    const Pack pz = Ops::Load( fromZ + i );
+    Pack qw = Ops::Load( toW + i );
+    Pack qx = Ops::Load( toX + i );
+    Pack qy = Ops::Load( toY + i );
+    Pack qz = Ops::Load( toZ + i );
+
+    // Take the shortest path: flip the sign of "to" if the dot product is negative
+    const Pack dot = Ops::Add( Ops::Add( Ops::Mul( pw, qw ), Ops::Mul( px, qx ) ),
+                               Ops::Add( Ops::Mul( py, qy ), Ops::Mul( pz, qz ) ) );
+    const Pack sign = Ops::Sign( dot );
+    qw = Ops::ApplySign( qw, sign );
+    qx = Ops::ApplySign( qx, sign );
+    qy = Ops::ApplySign( qy, sign );
+    qz = Ops::ApplySign( qz, sign );
+    const Pack xm1 = Ops::Sub( Ops::Min( Ops::Abs( dot ), one ), one );
+
+    // Coefficients sin((1-t)*theta)/sin(theta) and sin(t*theta)/sin(theta)
+    const Pack tt = Ops::Load( t + i );
+    const Pack dd = Ops::Sub( one, tt );
+    const Pack sqrT = Ops::Mul( tt, tt );
+    const Pack sqrD = Ops::Mul( dd, dd );
+    Pack accT = one;
+    Pack accD = one;
+    for (int k = SlerpSeriesLength - 1; k >= 0; --k)
+      {
+      const Pack u = Ops::Set( SlerpCoefficients.U[k] );
+      const Pack v = Ops::Set( SlerpCoefficients.V[k] );
+      accT = Ops::Add( one, Ops::Mul( Ops::Mul( Ops::Sub( Ops::Mul( u, sqrT ), v ), xm1 ), accT ) );
+      accD = Ops::Add( one, Ops::Mul( Ops::Mul( Ops::Sub( Ops::Mul( u, sqrD ), v ), xm1 ), accD ) );
+      }
+    const Pack cT = Ops::Mul( tt, accT );
+    const Pack cD = Ops::Mul( dd, accD );
+
+    Pack rw = Ops::Add( Ops::Mul( cD, pw ), Ops::Mul( cT, qw ) );
+    Pack rx = Ops::Add( Ops::Mul( cD, px ), Ops::Mul( cT, qx ) );
+    Pack ry = Ops::Add( Ops::Mul( cD, py ), Ops::Mul( cT, qy ) );
+    Pack rz = Ops::Add( Ops::Mul( cD, pz ), Ops::Mul( cT, qz ) );
+
+    // Renormalize to avoid drift of repeatedly interpolated rotations
+    const Pack norm = Ops::Sqrt( Ops::Add( Ops::Add( Ops::Mul( rw, rw ), Ops::Mul( rx, rx ) ),
+                                           Ops::Add( Ops::Mul( ry, ry ), Ops::Mul( rz, rz ) ) ) );
+    Ops::Store( resultW + i, Ops::Div( rw, norm ) );
+    Ops::Store( resultX + i, Ops::Div( rx, norm ) );
+    Ops::Store( resultY + i, Ops::Div( ry, norm ) );
+    Ops::Store( resultZ + i, Ops::Div( rz, norm ) );
+    }
+  return i;
+}
+
+//----------------------------------------------------------------------------
+// Normalized linear interpolation of the quaternion pairs [begin, end) by packs of Ops::Width.
+// Returns the index of the first pair that has not been processed (less than one pack left).
+template <class Ops>
+int NlerpPacks(int begin, int end, const double* t,
+               const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+               const double* toW, const double* toX, const double* toY, const double* toZ,
+               double* resultW, double* resultX, double* resultY, double* resultZ)
+{
+  typedef typename Ops::Pack Pack;
+  const Pack one = Ops::Set( 1.0 );
+
+  int i = begin;
+  for (; i + Ops::Width <= end; i += Ops::Width)
+    {
+    const Pack pw = Ops::Load( fromW + i );
+    const Pack px = Ops::Load( fromX + i );
+    const Pack py = Ops::Load( fromY + i );
+    const Pack pz = Ops::Load( fromZ + i );
+    const Pack qw = Ops::Load( toW + i );
+    const Pack qx = Ops::Load( toX + i );
+    const Pack qy = Ops::Load( toY + i );
+    const Pack qz = Ops::Load( toZ + i );
+
+    // Take the shortest path: flip the sign of the weight of "to" if the dot product is negative
+    const Pack dot = Ops::Add( Ops::Add( Ops::Mul( pw, qw ), Ops::Mul( px, qx ) ),
+                               Ops::Add( Ops::Mul( py, qy ), Ops::Mul( pz, qz ) ) );
+    const Pack tt = Ops::Load( t + i );
+    const Pack cT = Ops::ApplySign( tt, Ops::Sign( dot ) );
+    const Pack cD = Ops::Sub( one, tt );
+
+    Pack rw = Ops::Add( Ops::Mul( cD, pw ), Ops::Mul( cT, qw ) );
+    Pack rx = Ops::Add( Ops::Mul( cD, px ), Ops::Mul( cT, qx ) );
+    Pack ry = Ops::Add( Ops::Mul( cD, py ), Ops::Mul( cT, qy ) );
+    Pack rz = Ops::Add( Ops::Mul( cD, pz ), Ops::Mul( cT, qz ) );
+
+    const Pack norm = Ops::Sqrt( Ops::Add( Ops::Add( Ops::Mul( rw, rw ), Ops::Mul( rx, rx ) ),
+                                           Ops::Add( Ops::Mul( ry, ry ), Ops::Mul( rz, rz ) ) ) );
+    Ops::Store( resultW + i, Ops::Div( rw, norm ) );
+    Ops::Store( resultX + i, Ops::Div( rx, norm ) );
+    Ops::Store( resultY + i, Ops::Div( ry, norm ) );
+    Ops::Store( resultZ + i, Ops::Div( rz, norm ) );
+    }
+  return i;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherBatchKernels
+::Slerp(int count, const double* t,
+        const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+        const double* toW, const double* toX, const double* toY, const double* toZ,
+        double* resultW, double* resultX, double* resultY, double* resultZ)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    const double p[4] = { fromW[i], fromX[i], fromY[i], fromZ[i] };
+    double q[4] = { toW[i], toX[i], toY[i], toZ[i] };
+
+    // Take the shortest path
+    double cosom = p[0]*q[0] + p[1]*q[1] + p[2]*q[2] + p[3]*q[3];
+    if ( cosom < 0.0 )
+      {
+      cosom = -cosom;
+      q[0] = -q[0];
+      q[1] = -q[1];
+      q[2] = -q[2];
+      q[3] = -q[3];
+      }
+
+    double sclp = 1.0 - t[i];
+    double sclq = t[i];
+    const double omega = acos( cosom < 1.0 ? cosom : 1.0 );
+    const double sinom = sin( omega );
+    if ( sinom > 1e-12 )
+      {
+      sclp = sin( ( 1.0 - t[i] ) * omega ) / sinom;
+      sclq = sin( t[i] * omega ) / sinom;
+      }
+
+    double r[4];
+    for (int c = 0; c < 4; ++c)
+      {
+      r[c] = sclp * p[c] + sclq * q[c];
+      }
+    const double norm = sqrt( r[0]*r[0] + r[1]*r[1] + r[2]*r[2] + r[3]*r[3] );
+    resultW[i] = r[0] / norm;
+    resultX[i] = r[1] / norm;
+    resultY[i] = r[2] / norm;
+    resultZ[i] = r[3] / norm;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherBatchKernels
+::PolynomialSlerp(int count, const double* t,
+                  const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+                  const double* toW, const double* toX, const double* toY, const double* toZ,
+                  double* resultW, double* resultX, double* resultY, double* resultZ)
+{
+  int i = 0;
+#if defined(TRANSFORMSMOOTHER_USE_AVX)
+  i = PolynomialSlerpPacks<AVXOperations>( i, count, t, fromW, fromX, fromY, fromZ,
+                                           toW, toX, toY, toZ, resultW, resultX, resultY, resultZ );
+#elif defined(TRANSFORMSMOOTHER_USE_SSE2)
+  i = PolynomialSlerpPacks<SSE2Operations>( i, count, t, fromW, fromX, fromY, fromZ,
+                                            toW, toX, toY, toZ, resultW, resultX, resultY, resultZ );
+#endif
+  // Remaining pairs
+  PolynomialSlerpPacks<ScalarOperations>( i, count, t, fromW, fromX, fromY, fromZ,
+                                          toW, toX, toY, toZ, resultW, resultX, resultY, resultZ );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherBatchKernels
+::Nlerp(int count, const double* t,
+        const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+        const double* toW, const double* toX, const double* toY, const double* toZ,
+        double* resultW, double* resultX, double* resultY, double* resultZ)
+{
+  int i = 0;
+#if defined(TRANSFORMSMOOTHER_USE_AVX)
+  i = NlerpPacks<AVXOperations>( i, count, t, fromW, fromX, fromY, fromZ,
+                                 toW, toX, toY, toZ, resultW, resultX, resultY, resultZ );
+#elif defined(TRANSFORMSMOOTHER_USE_SSE2)
+  i = NlerpPacks<SSE2Operations>( i, count, t, fromW, fromX, fromY, fromZ,
+                                  toW, toX, toY, toZ, resultW, resultX, resultY, resultZ );
+#endif
+  // Remaining pairs
+  NlerpPacks<ScalarOperations>( i, count, t, fromW, fromX, fromY, fromZ,
+                                toW, toX, toY, toZ, resultW, resultX, resultY, resultZ );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherBatchKernels
+::Lerp(int count, const double* t, const double* from, const double* to, double* result)
+{
+  for (int i = 0; i < count; ++i)
+    {
+    result[i] = from[i] + t[i] * ( to[i] - from[i] );
+    }
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerTransformSmootherBatchKernels::GetInstructionSet()
+{
+#if defined(TRANSFORMSMOOTHER_USE_AVX)
+  return "AVX";
+#elif defined(TRANSFORMSMOOTHER_USE_SSE2)
+  return "SSE2";
+#else
+  return "Scalar";
+#endif
+}
@@ -0,0 +1,74 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherBatchKernels - vectorized kernels filtering many transforms at once
+// .SECTION Description
+// Kernels operating on poses stored as structure of arrays (one array per quaternion
+// or translation component), used by vtkSlicerTransformSmootherFilterBank to update all
+// filters in a single pass. Several quaternion pairs are processed per instruction
+// using AVX (4 pairs) or SSE2 (2 pairs) when the compiler targets these instruction
+// sets (e.g. -mavx2), with a scalar fallback otherwise.
+
+#ifndef __vtkSlicerTransformSmootherBatchKernels_h
+#define __vtkSlicerTransformSmootherBatchKernels_h
+
+#include "vtkSlicerTransformSmootherModuleCoreExport.h"
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT vtkSlicerTransformSmootherBatchKernels
+{
+public:
+  /// Interpolation of count quaternion pairs (w, x, y, z):
+  /// result[i] = interpolation(from[i], to[i], t[i]) with t[i] in [0, 1], taking the shortest path.
+  /// Result arrays may be the same as the from or to arrays. Results are normalized.
+  typedef void (*RotationInterpolationFunction)(int count, const double* t,
+    const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+    const double* toW, const double* toX, const double* toY, const double* toZ,
+    double* resultW, double* resultX, double* resultY, double* resultZ);
+
+  /// Exact spherical linear interpolation, computed with acos/sin for each pair (not vectorized).
+  static void Slerp(int count, const double* t,
+                    const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+                    const double* toW, const double* toX, const double* toY, const double* toZ,
+                    double* resultW, double* resultX, double* resultY, double* resultZ);
+
+  /// Spherical linear interpolation with branchless sign adjustment and interpolation
+  /// coefficients computed with a polynomial approximation of sin(t*theta)/sin(theta)
+  /// (D. Eberly, A Fast and Accurate Algorithm for Computing SLERP, 2011), avoiding acos/sin
+  /// calls. The error is at the level of double precision rounding (1e-15) for rotations up to
+  /// 60 degrees between the quaternions and below 4e-8 in the worst case (180 degree rotation).
+  static void PolynomialSlerp(int count, const double* t,
+                              const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+                              const double* toW, const double* toX, const double* toY, const double* toZ,
+                              double* resultW, double* resultX, double* resultY, double* resultZ);
+
+  /// Normalized linear interpolation. The interpolated rotation follows the same path as slerp
+  /// but not at constant speed, the angular error grows with the cube of the rotation angle.
+  static void Nlerp(int count, const double* t,
+                    const double* fromW, const double* fromX, const double* fromY, const double* fromZ,
+                    const double* toW, const double* toX, const double* toY, const double* toZ,
+                    double* resultW, double* resultX, double* resultY, double* resultZ);
+
+  /// Linear interpolation of count values: result[i] = from[i] + t[i] * (to[i] - from[i]).
+  /// Result array may be the same as the from or to arrays.
+  static void Lerp(int count, const double* t, const double* from, const double* to, double* result);
+
+  /// Name of the instruction set used by the kernels: "AVX", "SSE2" or "Scalar"
+  static const char* GetInstructionSet();
+};
+
+#endif
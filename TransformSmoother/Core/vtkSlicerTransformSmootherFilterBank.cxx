@@ -0,0 +1,1126 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherBatchKernels.h"
+#include "vtkSlicerTransformSmootherFilterBank.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Number of consecutive filters updated by a parallel task, large enough for the task
+// overhead to be negligible and for tasks not to share cache lines
+const vtkIdType ParallelBlockSize = 256;
+}
+
+//----------------------------------------------------------------------------
+// Updates blocks of consecutive filters of a filter bank
+class vtkSlicerTransformSmootherFilterBank::SetSamplesFunctor
+{
+public:
+  SetSamplesFunctor(vtkSlicerTransformSmootherFilterBank* filters, double timestamp,
+    const vtkSlicerTransformSmootherPoseArrays& samples, const std::vector< unsigned char >& validSamples)
+    : Filters( filters ), Timestamp( timestamp ), Samples( samples ), ValidSamples( validSamples )
+  {
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    this->Filters->SetSamplesBlock( static_cast<int>( begin ), static_cast<int>( end ),
+      this->Timestamp, this->Samples, this->ValidSamples );
+  }
+
+private:
+  vtkSlicerTransformSmootherFilterBank* Filters;
+  double Timestamp;
+  const vtkSlicerTransformSmootherPoseArrays& Samples;
+  const std::vector< unsigned char >& ValidSamples;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherFilterBank::FilterParameters::FilterParameters()
+{
+  this->Activated = false;
+  this->FilterMode = FilterLowPass;
+  this->FilterOrder = 2;
+  this->CutOffFrequency = 7.5;
+  this->MinCutOffFrequency = 1.0;
+  this->Beta = 0.05;
+  this->PredictionTime = 0.0;
+  this->ProcessNoise = 500.0;
+  this->MeasurementNoise = 0.2;
+  this->InterpolationMode = InterpolationPolynomialSlerp;
+  this->OutputRate = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherFilterBank::vtkSlicerTransformSmootherFilterBank()
+{
+  this->FilterGroupsModified = true;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherFilterBank::GetNumberOfFilters() const
+{
+  return static_cast<int>( this->Activated.size() );
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherFilterBank::AddFilter()
+{
+  const int index = this->GetNumberOfFilters();
+  this->Resize( index + 1 );
+  this->SetFilterParameters( index, FilterParameters() );
+  return index;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherFilterBank::RemoveFilter(int index)
+{
+  const int lastIndex = this->GetNumberOfFilters() - 1;
+  if ( index < 0 || index > lastIndex )
+    {
+    return -1;
+    }
+  if ( index != lastIndex )
+    {
+    this->Move( lastIndex, index );
+    }
+  this->Resize( lastIndex );
+  return ( index != lastIndex ) ? lastIndex : -1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::RemoveFilters(int first, int count)
+{
+  const int numberOfFilters = this->GetNumberOfFilters();
+  if ( first < 0 || count <= 0 || first + count > numberOfFilters )
+    {
+    return;
+    }
+  for (int i = first + count; i < numberOfFilters; ++i)
+    {
+    this->Move( i, i - count );
+    }
+  this->Resize( numberOfFilters - count );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::RemoveAllFilters()
+{
+  this->Resize( 0 );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::SetFilterParameters(int index, const FilterParameters& parameters)
+{
+  const bool modeChanged = ( this->FilterModes[index] != parameters.FilterMode
+    || this->FilterOrders[index] != parameters.FilterOrder );
+  this->CutOffFrequencies[index] = parameters.CutOffFrequency;
+  this->Activated[index] = parameters.Activated ? 1 : 0;
+  this->FilterModes[index] = parameters.FilterMode;
+  this->FilterOrders[index] = parameters.FilterOrder;
+  this->MinCutOffFrequencies[index] = parameters.MinCutOffFrequency;
+  this->Betas[index] = parameters.Beta;
+  this->PredictionTimes[index] = parameters.PredictionTime;
+  this->ProcessNoises[index] = parameters.ProcessNoise;
+  this->MeasurementNoises[index] = parameters.MeasurementNoise;
+  this->InterpolationModes[index] = parameters.InterpolationMode;
+  const unsigned char updateType = static_cast<unsigned char>( GetUpdateType( parameters.FilterMode, parameters.FilterOrder ) );
+  if ( this->UpdateTypes[index] != updateType )
+    {
+    this->UpdateTypes[index] = updateType;
+    this->FilterGroupsModified = true;
+    }
+  this->InterpolationFunctions[index] = GetInterpolationFunction( parameters.InterpolationMode );
+  if ( this->OutputRates[index] != parameters.OutputRate )
+    {
+    // Restart the output schedule: the next sample is written
+    this->OutputRates[index] = parameters.OutputRate;
+    this->NextOutputTimes[index] = this->LastTimestamps[index];
+    }
+  if ( modeChanged )
+    {
+    // Filter states are only maintained by their own filter mode, restart them
+    this->ResetFilterState( index );
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherFilterBank::GetFilterActivated(int index) const
+{
+  return this->Activated[index] != 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherFilterBank::SetSample(int index, double timestamp,
+  const double rotation[4], const double translation[3], bool smooth)
+{
+  if ( !this->AcceptSample( index, timestamp, rotation, translation ) )
+    {
+    return false;
+    }
+  if ( !this->PendingUpdates[index] )
+    {
+    return true;
+    }
+
+  // Update the cached filtered pose with the new sample.
+  // Only the new sample needs to be decomposed, the previous output is kept in the filter state.
+  this->PendingUpdates[index] = 0;
+  this->UpdateFilter( index, this->SampleIntervals[index] );
+  if ( smooth )
+    {
+    this->SmoothPoses( index, 1 );
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherFilterBank::AcceptSample(int index, double timestamp,
+  const double rotation[4], const double translation[3])
+{
+  // Elapsed time since the previous sample of this filter
+  const bool firstSample = !this->Initialized[index];
+  const double dt = timestamp - this->LastTimestamps[index];
+  if ( !firstSample && dt <= 0.0 )
+    {
+    // Sample is not newer than the previous one (duplicate timestamp), nothing to update
+    this->ClearSample( index );
+    return false;
+    }
+  if ( this->OutputRates[index] > 0.0 )
+    {
+    // Keep the output pose of the previous sample, the output may be interpolated from it
+    double previousRotation[4];
+    double previousTranslation[3];
+    if ( firstSample )
+      {
+      this->NextOutputTimes[index] = timestamp;
+      this->PreviousOutputPoses.SetPose( index, rotation, translation );
+      }
+    else
+      {
+      this->GetOutputPose( index, previousRotation, previousTranslation );
+      this->PreviousOutputPoses.SetPose( index, previousRotation, previousTranslation );
+      }
+    this->PreviousTimestamps[index] = firstSample ? timestamp : this->LastTimestamps[index];
+    }
+  this->LastTimestamps[index] = timestamp;
+  this->Initialized[index] = 1;
+  this->Updated[index] = 1;
+  this->Samples.SetPose( index, rotation, translation );
+
+  if ( !this->Activated[index] || firstSample )
+    {
+    // No filter (or nothing to filter with yet): filtered pose is the input pose
+    this->Poses.SetPose( index, rotation, translation );
+    this->Alphas[index] = 0.0;
+    this->RotationAlphas[index] = 0.0;
+    this->ResetFilterState( index );
+    return true;
+    }
+  this->PendingUpdates[index] = 1;
+  this->SampleIntervals[index] = dt;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::SetSamples(double timestamp,
+  const vtkSlicerTransformSmootherPoseArrays& samples, const std::vector< unsigned char >& validSamples)
+{
+  this->SetSamples( timestamp, samples, validSamples, 0, this->GetNumberOfFilters() );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::SetSamples(double timestamp,
+  const vtkSlicerTransformSmootherPoseArrays& samples, const std::vector< unsigned char >& validSamples,
+  int first, int count)
+{
+  if ( this->FilterGroupsModified )
+    {
+    this->UpdateFilterGroups();
+    }
+  SetSamplesFunctor functor( this, timestamp, samples, validSamples );
+  if ( count <= ParallelBlockSize )
+    {
+    // A single block (e.g. one filter per input event) is updated on the calling thread,
+    // without the task dispatch of the SMP backend and its allocations
+    functor( first, first + count );
+    return;
+    }
+  vtkSMPTools::For( first, first + count, ParallelBlockSize, functor );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::ClearSample(int index)
+{
+  this->Alphas[index] = 0.0;
+  this->RotationAlphas[index] = 0.0;
+  this->Updated[index] = 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherFilterBank::HasSample(int index) const
+{
+  return this->Updated[index] != 0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerTransformSmootherFilterBank::GetSmoothingFactor(double dt, double cutoffFrequency)
+{
+  // First-order low-pass filter: the new sample has weight dt*cutoff relative to the previous output
+  const double weightPrevious = 1.0;
+  const double weightCurrent = dt * cutoffFrequency;
+  return weightCurrent / ( weightPrevious + weightCurrent );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::SetSamplesBlock(int begin, int end, double timestamp,
+  const vtkSlicerTransformSmootherPoseArrays& samples, const std::vector< unsigned char >& validSamples)
+{
+  for (int i = begin; i < end; ++i)
+    {
+    if ( !validSamples[i] )
+      {
+      this->ClearSample( i );
+      continue;
+      }
+    double rotation[4];
+    double translation[3];
+    samples.GetPose( i, rotation, translation );
+    this->AcceptSample( i, timestamp, rotation, translation );
+    }
+
+  // One loop per update type, the update is resolved at compile time
+  this->UpdateFilters<UpdateLowPass>( begin, end );
+  this->UpdateFilters<UpdateOneEuro>( begin, end );
+  this->UpdateFilters<UpdateButterworth2>( begin, end );
+  this->UpdateFilters<UpdateButterworth4>( begin, end );
+  this->UpdateFilters<UpdateKalman>( begin, end );
+
+  this->SmoothPoses( begin, end - begin );
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherFilterBank::GetUpdateType(int filterMode, int filterOrder)
+{
+  switch ( filterMode )
+    {
+    case FilterOneEuro:
+      return UpdateOneEuro;
+    case FilterButterworth:
+      return ( filterOrder > 2 ) ? UpdateButterworth4 : UpdateButterworth2;
+    case FilterKalman:
+      return UpdateKalman;
+    default:
+      return UpdateLowPass;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <int Type>
+inline void vtkSlicerTransformSmootherFilterBank::UpdateFilter(int index, double dt)
+{
+  // Type is a constant, only one branch is compiled in each specialization
+  switch ( Type )
+    {
+    case UpdateOneEuro:
+      this->ComputeOneEuroSmoothingFactors( index, dt );
+      break;
+    case UpdateButterworth2:
+      this->UpdateButterworthPose<2>( index, dt );
+      break;
+    case UpdateButterworth4:
+      this->UpdateButterworthPose<4>( index, dt );
+      break;
+    case UpdateKalman:
+      this->UpdateKalmanPose( index, dt );
+      break;
+    default:
+      this->ComputeLowPassSmoothingFactors( index, dt );
+      break;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <int Type>
+void vtkSlicerTransformSmootherFilterBank::UpdateFilters(int begin, int end)
+{
+  const std::vector< int >& group = this->FilterGroups[Type];
+  for (std::vector< int >::const_iterator it = std::lower_bound( group.begin(), group.end(), begin );
+    it != group.end() && *it < end; ++it)
+    {
+    const int index = *it;
+    if ( !this->PendingUpdates[index] )
+      {
+      continue;
+      }
+    this->PendingUpdates[index] = 0;
+    this->UpdateFilter<Type>( index, this->SampleIntervals[index] );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::UpdateFilter(int index, double dt)
+{
+  switch ( this->UpdateTypes[index] )
+    {
+    case UpdateOneEuro:
+      this->UpdateFilter<UpdateOneEuro>( index, dt );
+      break;
+    case UpdateButterworth2:
+      this->UpdateFilter<UpdateButterworth2>( index, dt );
+      break;
+    case UpdateButterworth4:
+      this->UpdateFilter<UpdateButterworth4>( index, dt );
+      break;
+    case UpdateKalman:
+      this->UpdateFilter<UpdateKalman>( index, dt );
+      break;
+    default:
+      this->UpdateFilter<UpdateLowPass>( index, dt );
+      break;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::UpdateFilterGroups()
+{
+  for (int type = 0; type < UpdateType_Last; ++type)
+    {
+    this->FilterGroups[type].clear();
+    }
+  const int numberOfFilters = this->GetNumberOfFilters();
+  for (int i = 0; i < numberOfFilters; ++i)
+    {
+    this->FilterGroups[ this->UpdateTypes[i] ].push_back( i );
+    }
+  this->FilterGroupsModified = false;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherBatchKernels::RotationInterpolationFunction
+vtkSlicerTransformSmootherFilterBank::GetInterpolationFunction(int interpolationMode)
+{
+  switch ( interpolationMode )
+    {
+    case InterpolationSlerp:
+      return vtkSlicerTransformSmootherBatchKernels::Slerp;
+    case InterpolationNlerp:
+      return vtkSlicerTransformSmootherBatchKernels::Nlerp;
+    default:
+      return vtkSlicerTransformSmootherBatchKernels::PolynomialSlerp;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::Resize(int size)
+{
+  this->CutOffFrequencies.resize( size, 0.0 );
+  this->Activated.resize( size, 0 );
+  this->FilterModes.resize( size, FilterLowPass );
+  this->FilterOrders.resize( size, 2 );
+  this->MinCutOffFrequencies.resize( size, 0.0 );
+  this->Betas.resize( size, 0.0 );
+  this->PredictionTimes.resize( size, 0.0 );
+  this->ProcessNoises.resize( size, 0.0 );
+  this->MeasurementNoises.resize( size, 0.0 );
+  this->InterpolationModes.resize( size, InterpolationPolynomialSlerp );
+  this->OutputRates.resize( size, 0.0 );
+  this->UpdateTypes.resize( size, UpdateLowPass );
+  this->FilterGroupsModified = true;
+  this->InterpolationFunctions.resize( size, vtkSlicerTransformSmootherBatchKernels::PolynomialSlerp );
+  this->LastTimestamps.resize( size, 0.0 );
+  this->Initialized.resize( size, 0 );
+  this->Poses.Resize( size );
+  this->NextOutputTimes.resize( size, 0.0 );
+  this->PreviousTimestamps.resize( size, 0.0 );
+  this->PreviousOutputPoses.Resize( size );
+  this->Velocities.Resize( size );
+  this->AngularVelocities.Resize( size );
+  this->SamplePeriods.resize( size, 0.0 );
+  this->ButterworthCoefficients.resize( size * ButterworthCoefficientsSize, 0.0 );
+  this->CoefficientOrders.resize( size, 0 );
+  this->CoefficientCutOffFrequencies.resize( size, 0.0 );
+  this->CoefficientSamplePeriods.resize( size, 0.0 );
+  this->ButterworthHistories.resize( size * ButterworthHistorySize, 0.0 );
+  this->KalmanCovariances.resize( size * KalmanCovariancesSize, 0.0 );
+  this->Samples.Resize( size );
+  this->Alphas.resize( size, 0.0 );
+  this->RotationAlphas.resize( size, 0.0 );
+  this->Updated.resize( size, 0 );
+  this->PendingUpdates.resize( size, 0 );
+  this->SampleIntervals.resize( size, 0.0 );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::Move(int from, int to)
+{
+  this->CutOffFrequencies[to] = this->CutOffFrequencies[from];
+  this->Activated[to] = this->Activated[from];
+  this->FilterModes[to] = this->FilterModes[from];
+  this->FilterOrders[to] = this->FilterOrders[from];
+  this->MinCutOffFrequencies[to] = this->MinCutOffFrequencies[from];
+  this->Betas[to] = this->Betas[from];
+  this->PredictionTimes[to] = this->PredictionTimes[from];
+  this->ProcessNoises[to] = this->ProcessNoises[from];
+  this->MeasurementNoises[to] = this->MeasurementNoises[from];
+  this->InterpolationModes[to] = this->InterpolationModes[from];
+  this->OutputRates[to] = this->OutputRates[from];
+  this->UpdateTypes[to] = this->UpdateTypes[from];
+  this->InterpolationFunctions[to] = this->InterpolationFunctions[from];
+  this->LastTimestamps[to] = this->LastTimestamps[from];
+  this->Initialized[to] = this->Initialized[from];
+  this->Poses.Move( from, to );
+  this->NextOutputTimes[to] = this->NextOutputTimes[from];
+  this->PreviousTimestamps[to] = this->PreviousTimestamps[from];
+  this->PreviousOutputPoses.Move( from, to );
+  this->Velocities.Move( from, to );
+  this->AngularVelocities.Move( from, to );
+  this->SamplePeriods[to] = this->SamplePeriods[from];
+  std::copy( this->ButterworthCoefficients.begin() + from * ButterworthCoefficientsSize,
+    this->ButterworthCoefficients.begin() + ( from + 1 ) * ButterworthCoefficientsSize,
+    this->ButterworthCoefficients.begin() + to * ButterworthCoefficientsSize );
+  this->CoefficientOrders[to] = this->CoefficientOrders[from];
+  this->CoefficientCutOffFrequencies[to] = this->CoefficientCutOffFrequencies[from];
+  this->CoefficientSamplePeriods[to] = this->CoefficientSamplePeriods[from];
+  std::copy( this->ButterworthHistories.begin() + from * ButterworthHistorySize,
+    this->ButterworthHistories.begin() + ( from + 1 ) * ButterworthHistorySize,
+    this->ButterworthHistories.begin() + to * ButterworthHistorySize );
+  std::copy( this->KalmanCovariances.begin() + from * KalmanCovariancesSize,
+    this->KalmanCovariances.begin() + ( from + 1 ) * KalmanCovariancesSize,
+    this->KalmanCovariances.begin() + to * KalmanCovariancesSize );
+  this->Samples.Move( from, to );
+  this->Alphas[to] = this->Alphas[from];
+  this->RotationAlphas[to] = this->RotationAlphas[from];
+  this->Updated[to] = this->Updated[from];
+  this->PendingUpdates[to] = this->PendingUpdates[from];
+  this->SampleIntervals[to] = this->SampleIntervals[from];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::ResetFilterState(int index)
+{
+  const double zero[3] = { 0.0, 0.0, 0.0 };
+  this->Velocities.SetVector( index, zero );
+  this->AngularVelocities.SetVector( index, zero );
+  this->ResetButterworthHistory( index );
+  this->ResetKalmanCovariances( index );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::ComputeLowPassSmoothingFactors(int index, double dt)
+{
+  this->Alphas[index] = GetSmoothingFactor( dt, this->CutOffFrequencies[index] );
+  this->RotationAlphas[index] = this->Alphas[index];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::ComputeOneEuroSmoothingFactors(int index, double dt)
+{
+  // Cutoff frequency of the low-pass filter of the speed estimates (in Hz)
+  const double derivativeCutOffFrequency = 1.0;
+  const double derivativeAlpha = GetOneEuroSmoothingFactor( dt, derivativeCutOffFrequency );
+
+  // Translation: speed of the sample relative to the previous filtered position
+  double velocity[3];
+  this->Velocities.GetVector( index, velocity );
+  const double rawVelocity[3] =
+    {
+    ( this->Samples.TranslationX[index] - this->Poses.TranslationX[index] ) / dt,
+    ( this->Samples.TranslationY[index] - this->Poses.TranslationY[index] ) / dt,
+    ( this->Samples.TranslationZ[index] - this->Poses.TranslationZ[index] ) / dt
+    };
+  for (int i = 0; i < 3; i++)
+    {
+    velocity[i] += derivativeAlpha * ( rawVelocity[i] - velocity[i] );
+    }
+  this->Velocities.SetVector( index, velocity );
+
+  // Rotation: angular velocity in the tangent space of the previous filtered orientation
+  double filteredRotation[4];
+  double sampleRotation[4];
+  double translation[3];
+  this->Poses.GetPose( index, filteredRotation, translation );
+  this->Samples.GetPose( index, sampleRotation, translation );
+  double rotationVector[3];
+  GetRotationVector( filteredRotation, sampleRotation, rotationVector );
+  double angularVelocity[3];
+  this->AngularVelocities.GetVector( index, angularVelocity );
+  for (int i = 0; i < 3; i++)
+    {
+    angularVelocity[i] += derivativeAlpha * ( rotationVector[i] / dt - angularVelocity[i] );
+    }
+  this->AngularVelocities.SetVector( index, angularVelocity );
+
+  const double minCutOffFrequency = this->MinCutOffFrequencies[index];
+  const double beta = this->Betas[index];
+  const double speed = vtkMath::Norm( velocity );
+  const double angularSpeed = vtkMath::DegreesFromRadians( vtkMath::Norm( angularVelocity ) );
+  this->Alphas[index] = GetOneEuroSmoothingFactor( dt, minCutOffFrequency + beta * speed );
+  this->RotationAlphas[index] = GetOneEuroSmoothingFactor( dt, minCutOffFrequency + beta * angularSpeed );
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerTransformSmootherFilterBank::GetOneEuroSmoothingFactor(double dt, double cutoffFrequency)
+{
+  // Exponential smoothing with time constant 1/(2*pi*cutoff)
+  const double r = 2.0 * vtkMath::Pi() * cutoffFrequency * dt;
+  return r / ( 1.0 + r );
+}
+
+//----------------------------------------------------------------------------
+template <int Order>
+void vtkSlicerTransformSmootherFilterBank::UpdateButterworthPose(int index, double dt)
+{
+  // Estimate the sample period. Coefficients are only recomputed when the estimate drifts
+  // away from the period they were designed for, or when filter parameters change.
+  double& samplePeriod = this->SamplePeriods[index];
+  samplePeriod = ( samplePeriod > 0.0 ) ? samplePeriod + 0.1 * ( dt - samplePeriod ) : dt;
+  double* coefficients = &this->ButterworthCoefficients[ index * ButterworthCoefficientsSize ];
+  const double cutoffFrequency = this->CutOffFrequencies[index];
+  if ( this->CoefficientOrders[index] != Order
+    || this->CoefficientCutOffFrequencies[index] != cutoffFrequency
+    || fabs( samplePeriod - this->CoefficientSamplePeriods[index] ) > 0.05 * this->CoefficientSamplePeriods[index] )
+    {
+    GetButterworthCoefficients( Order, cutoffFrequency, samplePeriod, coefficients );
+    this->CoefficientOrders[index] = Order;
+    this->CoefficientCutOffFrequencies[index] = cutoffFrequency;
+    this->CoefficientSamplePeriods[index] = samplePeriod;
+    }
+
+  // Filter inputs: translation, and rotation in the tangent space of the current estimate
+  double rotation[4];
+  double translation[3];
+  double sampleRotation[4];
+  double sampleTranslation[3];
+  this->Poses.GetPose( index, rotation, translation );
+  this->Samples.GetPose( index, sampleRotation, sampleTranslation );
+  double input[6];
+  double output[6];
+  input[0] = sampleTranslation[0];
+  input[1] = sampleTranslation[1];
+  input[2] = sampleTranslation[2];
+  GetRotationVector( rotation, sampleRotation, input + 3 );
+
+  // Cascaded biquads, direct form I. Each channel keeps the last two inputs and outputs of each
+  // section (the output of the first section is the input of the second one).
+  // The number of sections is a constant, so that the loops over sections are unrolled.
+  double* history = &this->ButterworthHistories[ index * ButterworthHistorySize ];
+  const int numberOfSections = Order / 2;
+  for (int channel = 0; channel < 6; ++channel)
+    {
+    double* h = history + channel * 6;
+    double x = input[channel];
+    for (int section = 0; section < numberOfSections; ++section)
+      {
+      const double* c = coefficients + section * 5;
+      double* xh = h + section * 2; // x[n-1], x[n-2]
+      double* yh = xh + 2;          // y[n-1], y[n-2]
+      const double y = c[0] * x + c[1] * xh[0] + c[2] * xh[1] - c[3] * yh[0] - c[4] * yh[1];
+      xh[1] = xh[0];
+      xh[0] = x;
+      x = y;
+      }
+    double* yh = h + numberOfSections * 2;
+    yh[1] = yh[0];
+    yh[0] = x;
+    output[channel] = x;
+    }
+
+  // New estimate. Rotation histories are then expressed in the tangent space of the new estimate:
+  // moving the origin by the output is exact for the linear filter (unit DC gain) and a first-order
+  // approximation on the rotation manifold, accurate for the small motion between two samples.
+  RotateByVector( rotation, output + 3, rotation );
+  const int historyLength = numberOfSections * 2 + 2;
+  for (int channel = 3; channel < 6; ++channel)
+    {
+    double* h = history + channel * 6;
+    for (int k = 0; k < historyLength; ++k)
+      {
+      h[k] -= output[channel];
+      }
+    }
+  this->Poses.SetPose( index, rotation, output );
+
+  // The filtered pose is computed right away, SmoothPoses leaves it unchanged
+  this->Alphas[index] = 0.0;
+  this->RotationAlphas[index] = 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::ResetButterworthHistory(int index)
+{
+  // Filter at rest at the current pose: all translation values equal the current translation,
+  // all rotation values are at the origin of the tangent space (the current rotation)
+  double* history = &this->ButterworthHistories[ index * ButterworthHistorySize ];
+  const double translation[3] =
+    {
+    this->Poses.TranslationX[index], this->Poses.TranslationY[index], this->Poses.TranslationZ[index]
+    };
+  for (int channel = 0; channel < 6; ++channel)
+    {
+    for (int k = 0; k < 6; ++k)
+      {
+      history[ channel * 6 + k ] = ( channel < 3 ) ? translation[channel] : 0.0;
+      }
+    }
+  this->SamplePeriods[index] = 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::GetButterworthCoefficients(int order, double cutoffFrequency, double samplePeriod, double coefficients[10])
+{
+  // Butterworth low-pass filter as a cascade of biquads designed by bilinear transform with
+  // frequency prewarping (R. Bristow-Johnson, Audio EQ Cookbook). Section k has quality factor
+  // Q = 1 / (2 sin((2k+1) pi / (2 order))). Each section has unit DC gain.
+  // The cutoff is kept below the Nyquist frequency.
+  const double nyquistLimit = 0.45 / samplePeriod;
+  const double fc = std::max( 1e-6, std::min( cutoffFrequency, nyquistLimit ) );
+  const double k = tan( vtkMath::Pi() * fc * samplePeriod );
+  const int numberOfSections = order / 2;
+  for (int section = 0; section < numberOfSections; ++section)
+    {
+    const double q = 1.0 / ( 2.0 * sin( ( 2 * section + 1 ) * vtkMath::Pi() / ( 2 * order ) ) );
+    const double norm = 1.0 / ( 1.0 + k / q + k * k );
+    double* c = coefficients + section * 5;
+    c[0] = k * k * norm;                      // b0
+    c[1] = 2.0 * c[0];                        // b1
+    c[2] = c[0];                              // b2
+    c[3] = 2.0 * ( k * k - 1.0 ) * norm;      // a1
+    c[4] = ( 1.0 - k / q + k * k ) * norm;    // a2
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::UpdateKalmanPose(int index, double dt)
+{
+  // Each translation and rotation coordinate is an independent constant-velocity model.
+  // Rotations are handled in the tangent space of the predicted rotation, where the predicted
+  // position is the origin, and with noise parameters converted from degrees to radians.
+  const double degreesToRadians = vtkMath::Pi() / 180.0;
+  const double translationProcessVariance = this->ProcessNoises[index] * this->ProcessNoises[index];
+  const double translationMeasurementVariance = this->MeasurementNoises[index] * this->MeasurementNoises[index];
+  const double rotationProcessVariance = translationProcessVariance * degreesToRadians * degreesToRadians;
+  const double rotationMeasurementVariance = translationMeasurementVariance * degreesToRadians * degreesToRadians;
+
+  double* covariances = &this->KalmanCovariances[ index * KalmanCovariancesSize ];
+  double translationCovariance[3];
+  double rotationCovariance[3];
+  PredictKalmanCovariance( dt, translationProcessVariance, covariances, translationCovariance );
+  PredictKalmanCovariance( dt, rotationProcessVariance, covariances + 3, rotationCovariance );
+
+  double rotation[4];
+  double translation[3];
+  double sampleRotation[4];
+  double sampleTranslation[3];
+  double velocity[3];
+  double angularVelocity[3];
+  this->Poses.GetPose( index, rotation, translation );
+  this->Samples.GetPose( index, sampleRotation, sampleTranslation );
+  this->Velocities.GetVector( index, velocity );
+  this->AngularVelocities.GetVector( index, angularVelocity );
+
+  // Predicted rotation, measured rotation in its tangent space
+  double rotationStep[3] = { angularVelocity[0] * dt, angularVelocity[1] * dt, angularVelocity[2] * dt };
+  RotateByVector( rotation, rotationStep, rotation );
+  double rotationInnovation[3];
+  GetRotationVector( rotation, sampleRotation, rotationInnovation );
+
+  double translationGains[2];
+  double rotationGains[2];
+  UpdateKalmanCovariance( translationMeasurementVariance, translationCovariance, translationGains, covariances );
+  UpdateKalmanCovariance( rotationMeasurementVariance, rotationCovariance, rotationGains, covariances + 3 );
+  for (int i = 0; i < 3; i++)
+    {
+    const double predictedPosition = translation[i] + velocity[i] * dt;
+    const double translationInnovation = sampleTranslation[i] - predictedPosition;
+    translation[i] = predictedPosition + translationGains[0] * translationInnovation;
+    velocity[i] += translationGains[1] * translationInnovation;
+    rotationStep[i] = rotationGains[0] * rotationInnovation[i];
+    angularVelocity[i] += rotationGains[1] * rotationInnovation[i];
+    }
+  RotateByVector( rotation, rotationStep, rotation );
+
+  this->Poses.SetPose( index, rotation, translation );
+  this->Velocities.SetVector( index, velocity );
+  this->AngularVelocities.SetVector( index, angularVelocity );
+
+  // The filtered pose is computed right away, SmoothPoses leaves it unchanged
+  this->Alphas[index] = 0.0;
+  this->RotationAlphas[index] = 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::ResetKalmanCovariances(int index)
+{
+  // Position known up to the measurement noise, velocity unknown (standard deviation of
+  // 100 mm/s or 100 deg/s)
+  const double degreesToRadians = vtkMath::Pi() / 180.0;
+  const double measurementVariance = this->MeasurementNoises[index] * this->MeasurementNoises[index];
+  const double velocityVariance = 100.0 * 100.0;
+  double* covariances = &this->KalmanCovariances[ index * KalmanCovariancesSize ];
+  covariances[0] = measurementVariance;
+  covariances[1] = 0.0;
+  covariances[2] = velocityVariance;
+  covariances[3] = measurementVariance * degreesToRadians * degreesToRadians;
+  covariances[4] = 0.0;
+  covariances[5] = velocityVariance * degreesToRadians * degreesToRadians;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::PredictKalmanCovariance(double dt, double processVariance, const double covariance[3], double predictedCovariance[3])
+{
+  // P = F P F^T + Q with F = [1 dt; 0 1] and Q = processVariance * [dt^4/4 dt^3/2; dt^3/2 dt^2]
+  const double dt2 = dt * dt;
+  predictedCovariance[0] = covariance[0] + 2.0 * dt * covariance[1] + dt2 * covariance[2] + 0.25 * dt2 * dt2 * processVariance;
+  predictedCovariance[1] = covariance[1] + dt * covariance[2] + 0.5 * dt2 * dt * processVariance;
+  predictedCovariance[2] = covariance[2] + dt2 * processVariance;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::UpdateKalmanCovariance(double measurementVariance, const double predictedCovariance[3],
+                         double gains[2], double updatedCovariance[3])
+{
+  // Measurement of the position only: H = [1 0]
+  const double innovationVariance = predictedCovariance[0] + measurementVariance;
+  gains[0] = ( innovationVariance > 0.0 ) ? predictedCovariance[0] / innovationVariance : 1.0;
+  gains[1] = ( innovationVariance > 0.0 ) ? predictedCovariance[1] / innovationVariance : 0.0;
+  updatedCovariance[0] = ( 1.0 - gains[0] ) * predictedCovariance[0];
+  updatedCovariance[1] = ( 1.0 - gains[0] ) * predictedCovariance[1];
+  updatedCovariance[2] = predictedCovariance[2] - gains[1] * predictedCovariance[1];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::GetOutputPose(int index, double rotation[4], double translation[3]) const
+{
+  this->Poses.GetPose( index, rotation, translation );
+  const double predictionTime = this->PredictionTimes[index];
+  if ( this->FilterModes[index] != FilterKalman || predictionTime == 0.0 )
+    {
+    return;
+    }
+
+  // Extrapolate with the estimated velocities to compensate latency
+  const double rotationStep[3] =
+    {
+    this->AngularVelocities.X[index] * predictionTime,
+    this->AngularVelocities.Y[index] * predictionTime,
+    this->AngularVelocities.Z[index] * predictionTime
+    };
+  RotateByVector( rotation, rotationStep, rotation );
+  translation[0] += this->Velocities.X[index] * predictionTime;
+  translation[1] += this->Velocities.Y[index] * predictionTime;
+  translation[2] += this->Velocities.Z[index] * predictionTime;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherFilterBank
+::GetResampledOutputPose(int index, double& outputTimestamp, double rotation[4], double translation[3])
+{
+  this->GetOutputPose( index, rotation, translation );
+  const double timestamp = this->LastTimestamps[index];
+  outputTimestamp = timestamp;
+  const double outputRate = this->OutputRates[index];
+  if ( !this->Activated[index] || outputRate <= 0.0 )
+    {
+    return true;
+    }
+
+  const double nextOutputTime = this->NextOutputTimes[index];
+  if ( timestamp < nextOutputTime )
+    {
+    return false;
+    }
+
+  // Output times missed for lack of samples are skipped, only the latest one is written
+  const double outputPeriod = 1.0 / outputRate;
+  outputTimestamp = nextOutputTime + floor( ( timestamp - nextOutputTime ) / outputPeriod ) * outputPeriod;
+  const double previousTimestamp = this->PreviousTimestamps[index];
+  if ( outputTimestamp <= previousTimestamp || timestamp <= previousTimestamp )
+    {
+    // Output time is not after the previous sample (first sample or output rate just changed):
+    // write the new pose and schedule the following outputs from it
+    outputTimestamp = timestamp;
+    this->NextOutputTimes[index] = timestamp + outputPeriod;
+    return true;
+    }
+  this->NextOutputTimes[index] = outputTimestamp + outputPeriod;
+  if ( outputTimestamp == timestamp )
+    {
+    return true;
+    }
+
+  // Interpolate between the output poses of the previous and new samples
+  const double weight = ( outputTimestamp - previousTimestamp ) / ( timestamp - previousTimestamp );
+  double previousRotation[4];
+  double previousTranslation[3];
+  this->PreviousOutputPoses.GetPose( index, previousRotation, previousTranslation );
+  double rotationVector[3];
+  GetRotationVector( previousRotation, rotation, rotationVector );
+  rotationVector[0] *= weight;
+  rotationVector[1] *= weight;
+  rotationVector[2] *= weight;
+  RotateByVector( previousRotation, rotationVector, rotation );
+  for (int i = 0; i < 3; i++)
+    {
+    translation[i] = previousTranslation[i] + weight * ( translation[i] - previousTranslation[i] );
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::GetRotationVector(const double from[4], const double to[4], double rotationVector[3])
+{
+  // delta = conj(from) * to
+  const double fw = from[0];
+  const double fx = -from[1];
+  const double fy = -from[2];
+  const double fz = -from[3];
+  double delta[4] =
+    {
+    fw*to[0] - fx*to[1] - fy*to[2] - fz*to[3],
+    fw*to[1] + fx*to[0] + fy*to[3] - fz*to[2],
+    fw*to[2] - fx*to[3] + fy*to[0] + fz*to[1],
+    fw*to[3] + fx*to[2] - fy*to[1] + fz*to[0]
+    };
+  if ( delta[0] < 0.0 )
+    {
+    // Shortest path
+    for (int i = 0; i < 4; i++)
+      {
+      delta[i] = -delta[i];
+      }
+    }
+  const double sinHalfAngle = sqrt( delta[1]*delta[1] + delta[2]*delta[2] + delta[3]*delta[3] );
+  // angle / sin(angle/2), tends to 2 for small angles
+  const double scale = ( sinHalfAngle > 1e-12 ) ? 2.0 * atan2( sinHalfAngle, delta[0] ) / sinHalfAngle : 2.0;
+  rotationVector[0] = delta[1] * scale;
+  rotationVector[1] = delta[2] * scale;
+  rotationVector[2] = delta[3] * scale;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::RotateByVector(const double rotation[4], const double rotationVector[3], double result[4])
+{
+  // result = rotation * exp(rotationVector / 2)
+  const double angle = vtkMath::Norm( rotationVector );
+  const double c = cos( 0.5 * angle );
+  // sin(angle/2) / angle, tends to 1/2 for small angles
+  const double scale = ( angle > 1e-12 ) ? sin( 0.5 * angle ) / angle : 0.5;
+  const double dw = c;
+  const double dx = rotationVector[0] * scale;
+  const double dy = rotationVector[1] * scale;
+  const double dz = rotationVector[2] * scale;
+  const double rw = rotation[0];
+  const double rx = rotation[1];
+  const double ry = rotation[2];
+  const double rz = rotation[3];
+  result[0] = rw*dw - rx*dx - ry*dy - rz*dz;
+  result[1] = rw*dx + rx*dw + ry*dz - rz*dy;
+  result[2] = rw*dy - rx*dz + ry*dw + rz*dx;
+  result[3] = rw*dz + rx*dy - ry*dx + rz*dw;
+  const double norm = sqrt( result[0]*result[0] + result[1]*result[1] + result[2]*result[2] + result[3]*result[3] );
+  for (int i = 0; i < 4; i++)
+    {
+    result[i] /= norm;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank::SmoothPoses(int first, int count)
+{
+  if ( count <= 0 )
+    {
+    return;
+    }
+
+  vtkSlicerTransformSmootherPoseArrays& poses = this->Poses;
+  const vtkSlicerTransformSmootherPoseArrays& samples = this->Samples;
+  const double* alphas = &this->Alphas[first];
+
+  // Interpolate rotations by runs of consecutive filters using the same interpolation
+  const int end = first + count;
+  for (int runStart = first; runStart < end; )
+    {
+    const vtkSlicerTransformSmootherBatchKernels::RotationInterpolationFunction interpolate =
+      this->InterpolationFunctions[runStart];
+    int runEnd = runStart + 1;
+    while ( runEnd < end && this->InterpolationFunctions[runEnd] == interpolate )
+      {
+      ++runEnd;
+      }
+
+    interpolate( runEnd - runStart, &this->RotationAlphas[runStart],
+      &poses.RotationW[runStart], &poses.RotationX[runStart], &poses.RotationY[runStart], &poses.RotationZ[runStart],
+      &samples.RotationW[runStart], &samples.RotationX[runStart], &samples.RotationY[runStart], &samples.RotationZ[runStart],
+      &poses.RotationW[runStart], &poses.RotationX[runStart], &poses.RotationY[runStart], &poses.RotationZ[runStart] );
+    runStart = runEnd;
+    }
+
+  vtkSlicerTransformSmootherBatchKernels::Lerp( count, alphas,
+    &poses.TranslationX[first], &samples.TranslationX[first], &poses.TranslationX[first] );
+  vtkSlicerTransformSmootherBatchKernels::Lerp( count, alphas,
+    &poses.TranslationY[first], &samples.TranslationY[first], &poses.TranslationY[first] );
+  vtkSlicerTransformSmootherBatchKernels::Lerp( count, alphas,
+    &poses.TranslationZ[first], &samples.TranslationZ[first], &poses.TranslationZ[first] );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::GetPoseFromMatrix(const double matrix[4][4], double rotation[4], double translation[3])
+{
+  double rotationMatrix[3][3];
+  for (int i = 0; i < 3; i++)
+    {
+    rotationMatrix[i][0] = matrix[i][0];
+    rotationMatrix[i][1] = matrix[i][1];
+    rotationMatrix[i][2] = matrix[i][2];
+    translation[i] = matrix[i][3];
+    }
+  vtkMath::Matrix3x3ToQuaternion( rotationMatrix, rotation );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherFilterBank
+::GetMatrixFromPose(const double rotation[4], const double translation[3], double matrix[4][4])
+{
+  double rotationMatrix[3][3];
+  vtkMath::QuaternionToMatrix3x3( rotation, rotationMatrix );
+  for (int i = 0; i < 3; i++)
+    {
+    matrix[i][0] = rotationMatrix[i][0];
+    matrix[i][1] = rotationMatrix[i][1];
+    matrix[i][2] = rotationMatrix[i][2];
+    matrix[i][3] = translation[i];
+    }
+  matrix[3][0] = 0.0;
+  matrix[3][1] = 0.0;
+  matrix[3][2] = 0.0;
+  matrix[3][3] = 1.0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherFilterBank
+::GetAveragePose(const vtkSlicerTransformSmootherPoseArrays& poses, const int* indices, int count,
+                 const double* weights, double rotation[4], double translation[3])
+{
+  // Upper triangle of M = sum(w * q * q^T), the sign-aligned weighted sum of the rotations
+  // and the weighted sum of the translations
+  double m[4][4] = { { 0.0 } };
+  double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+  double reference[4] = { 1.0, 0.0, 0.0, 0.0 };
+  double totalWeight = 0.0;
+  translation[0] = translation[1] = translation[2] = 0.0;
+  for (int k = 0; k < count; ++k)
+    {
+    const int index = indices[k];
+    const double weight = weights[index];
+    if ( weight <= 0.0 )
+      {
+      continue;
+      }
+    double q[4];
+    double t[3];
+    poses.GetPose( index, q, t );
+    if ( totalWeight == 0.0 )
+      {
+      reference[0] = q[0];
+      reference[1] = q[1];
+      reference[2] = q[2];
+      reference[3] = q[3];
+      }
+    const double sign = ( q[0] * reference[0] + q[1] * reference[1] + q[2] * reference[2] + q[3] * reference[3] < 0.0 ) ? -weight : weight;
+    for (int i = 0; i < 4; ++i)
+      {
+      sum[i] += sign * q[i];
+      for (int j = i; j < 4; ++j)
+        {
+        m[i][j] += weight * q[i] * q[j];
+        }
+      }
+    translation[0] += weight * t[0];
+    translation[1] += weight * t[1];
+    translation[2] += weight * t[2];
+    totalWeight += weight;
+    }
+  if ( totalWeight <= 0.0 )
+    {
+    return false;
+    }
+  translation[0] /= totalWeight;
+  translation[1] /= totalWeight;
+  translation[2] /= totalWeight;
+  for (int i = 1; i < 4; ++i)
+    {
+    for (int j = 0; j < i; ++j)
+      {
+      m[i][j] = m[j][i];
+      }
+    }
+
+  // The aligned sum is close to the eigenvector (its dot product with the first rotation is at least
+  // the weight of that rotation, so it is not zero); power iteration refines it
+  double norm = sqrt( sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2] + sum[3] * sum[3] );
+  double q[4] = { sum[0] / norm, sum[1] / norm, sum[2] / norm, sum[3] / norm };
+  const int maxIterations = 32;
+  for (int iteration = 0; iteration < maxIterations; ++iteration)
+    {
+    double next[4];
+    for (int i = 0; i < 4; ++i)
+      {
+      next[i] = m[i][0] * q[0] + m[i][1] * q[1] + m[i][2] * q[2] + m[i][3] * q[3];
+      }
+    norm = sqrt( next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3] );
+    if ( norm <= 0.0 )
+      {
+      break;
+      }
+    double change = 0.0;
+    for (int i = 0; i < 4; ++i)
+      {
+      next[i] /= norm;
+      change += ( next[i] - q[i] ) * ( next[i] - q[i] );
+      q[i] = next[i];
+      }
+    if ( change < 1e-24 )
+      {
+      break;
+      }
+    }
+
+  const double sign = ( q[0] * reference[0] + q[1] * reference[1] + q[2] * reference[2] + q[3] * reference[3] < 0.0 ) ? -1.0 : 1.0;
+  rotation[0] = sign * q[0];
+  rotation[1] = sign * q[1];
+  rotation[2] = sign * q[2];
+  rotation[3] = sign * q[3];
+  return true;
+}
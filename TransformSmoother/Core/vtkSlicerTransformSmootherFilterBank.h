@@ -0,0 +1,417 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherFilterBank - pose filters independent of MRML and Qt
+// .SECTION Description
+// State and update of any number of pose filters (rotation as unit quaternion and translation),
+// identified by their index. Filters are stored as a structure of arrays so that all filters
+// can be updated in a single pass with the batch kernels. Only depends on the standard library
+// and VTK math, so that it can be embedded in non-GUI processes (e.g. a tracking server).
+// vtkSlicerTransformSmootherLogic uses a filter bank for the module nodes of the scene.
+//
+// Once a filter exists no heap allocation is performed when processing samples.
+
+#ifndef __vtkSlicerTransformSmootherFilterBank_h
+#define __vtkSlicerTransformSmootherFilterBank_h
+
+#include "vtkSlicerTransformSmootherModuleCoreExport.h"
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherBatchKernels.h"
+
+// STD includes
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Poses stored as a structure of arrays: rotations as unit quaternions (w, x, y, z) and translations
+class vtkSlicerTransformSmootherPoseArrays
+{
+public:
+  void Resize(int size)
+  {
+    this->RotationW.resize( size, 1.0 );
+    this->RotationX.resize( size, 0.0 );
+    this->RotationY.resize( size, 0.0 );
+    this->RotationZ.resize( size, 0.0 );
+    this->TranslationX.resize( size, 0.0 );
+    this->TranslationY.resize( size, 0.0 );
+    this->TranslationZ.resize( size, 0.0 );
+  }
+
+  void Move(int from, int to)
+  {
+    this->RotationW[to] = this->RotationW[from];
+    this->RotationX[to] = this->RotationX[from];
+    this->RotationY[to] = this->RotationY[from];
+    this->RotationZ[to] = this->RotationZ[from];
+    this->TranslationX[to] = this->TranslationX[from];
+    this->TranslationY[to] = this->TranslationY[from];
+    this->TranslationZ[to] = this->TranslationZ[from];
+  }
+
+  /// Remove count poses starting at first, the following poses keep their order
+  void Erase(int first, int count)
+  {
+    const int size = static_cast<int>( this->RotationW.size() );
+    for (int i = first + count; i < size; ++i)
+      {
+      this->Move( i, i - count );
+      }
+    this->Resize( size - count );
+  }
+
+  void SetPose(int index, const double rotation[4], const double translation[3])
+  {
+    this->RotationW[index] = rotation[0];
+    this->RotationX[index] = rotation[1];
+    this->RotationY[index] = rotation[2];
+    this->RotationZ[index] = rotation[3];
+    this->TranslationX[index] = translation[0];
+    this->TranslationY[index] = translation[1];
+    this->TranslationZ[index] = translation[2];
+  }
+
+  void GetPose(int index, double rotation[4], double translation[3]) const
+  {
+    rotation[0] = this->RotationW[index];
+    rotation[1] = this->RotationX[index];
+    rotation[2] = this->RotationY[index];
+    rotation[3] = this->RotationZ[index];
+    translation[0] = this->TranslationX[index];
+    translation[1] = this->TranslationY[index];
+    translation[2] = this->TranslationZ[index];
+  }
+
+  std::vector<double> RotationW;
+  std::vector<double> RotationX;
+  std::vector<double> RotationY;
+  std::vector<double> RotationZ;
+  std::vector<double> TranslationX;
+  std::vector<double> TranslationY;
+  std::vector<double> TranslationZ;
+};
+
+//----------------------------------------------------------------------------
+// 3D vectors stored as a structure of arrays
+class vtkSlicerTransformSmootherVectorArrays
+{
+public:
+  void Resize(int size)
+  {
+    this->X.resize( size, 0.0 );
+    this->Y.resize( size, 0.0 );
+    this->Z.resize( size, 0.0 );
+  }
+
+  void Move(int from, int to)
+  {
+    this->X[to] = this->X[from];
+    this->Y[to] = this->Y[from];
+    this->Z[to] = this->Z[from];
+  }
+
+  void SetVector(int index, const double vector[3])
+  {
+    this->X[index] = vector[0];
+    this->Y[index] = vector[1];
+    this->Z[index] = vector[2];
+  }
+
+  void GetVector(int index, double vector[3]) const
+  {
+    vector[0] = this->X[index];
+    vector[1] = this->Y[index];
+    vector[2] = this->Z[index];
+  }
+
+  std::vector<double> X;
+  std::vector<double> Y;
+  std::vector<double> Z;
+};
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT vtkSlicerTransformSmootherFilterBank
+{
+public:
+  /// Filter applied to the samples, see vtkMRMLTransformSmootherNode for details
+  enum FilterModeType
+    {
+    FilterLowPass = 0,
+    FilterOneEuro,
+    FilterButterworth,
+    FilterKalman,
+    FilterMode_Last // must be last
+    };
+
+  /// Interpolation of rotations, see vtkMRMLTransformSmootherNode for details
+  enum InterpolationModeType
+    {
+    InterpolationSlerp = 0,
+    InterpolationPolynomialSlerp,
+    InterpolationNlerp,
+    InterpolationMode_Last // must be last
+    };
+
+  /// Parameters of a filter
+  struct FilterParameters
+  {
+    FilterParameters();
+
+    bool Activated;
+    int FilterMode;
+    int FilterOrder;
+    double CutOffFrequency;
+    double MinCutOffFrequency;
+    double Beta;
+    double PredictionTime;
+    double ProcessNoise;
+    double MeasurementNoise;
+    int InterpolationMode;
+    double OutputRate;
+  };
+
+  vtkSlicerTransformSmootherFilterBank();
+
+  int GetNumberOfFilters() const;
+
+  /// Add a filter with default parameters and return its index
+  int AddFilter();
+  /// Remove the filter at index. The last filter is moved to the freed index:
+  /// returns its previous index, or -1 if the removed filter was the last one.
+  int RemoveFilter(int index);
+  /// Remove count consecutive filters starting at first. The following filters are moved down by count,
+  /// so that they keep their order, e.g. filters of a multi-channel module node stay consecutive.
+  void RemoveFilters(int first, int count);
+  /// Remove all filters
+  void RemoveAllFilters();
+
+  /// Set the parameters of the filter at index. The filter state is restarted from the current
+  /// filtered pose if the filter mode or order changes.
+  void SetFilterParameters(int index, const FilterParameters& parameters);
+  bool GetFilterActivated(int index) const;
+
+  /// Set a new input sample (acquired at timestamp, in seconds) of the filter at index.
+  /// If smooth is true the filtered pose is updated right away, otherwise it is updated
+  /// by the next SmoothPoses call, which updates all filters at once.
+  /// Returns false if the sample is not newer than the previous one.
+  bool SetSample(int index, double timestamp, const double rotation[4], const double translation[3],
+                 bool smooth = true);
+  /// Mark the filter at index as having no new sample for the next SmoothPoses call
+  void ClearSample(int index);
+  /// True if the filter at index got a new sample since its last ClearSample call
+  bool HasSample(int index) const;
+
+  /// Set new input samples (acquired at timestamp) of all filters and update their filtered poses.
+  /// Filters whose element of validSamples is 0 get no sample; HasSample tells which samples
+  /// were accepted. Filters are independent, so they are updated in parallel (vtkSMPTools)
+  /// by blocks of consecutive filters. A single block is updated on the calling thread.
+  void SetSamples(double timestamp, const vtkSlicerTransformSmootherPoseArrays& samples,
+                  const std::vector< unsigned char >& validSamples);
+  /// Same as SetSamples for the count consecutive filters starting at first only
+  void SetSamples(double timestamp, const vtkSlicerTransformSmootherPoseArrays& samples,
+                  const std::vector< unsigned char >& validSamples, int first, int count);
+
+  /// Move the filtered poses of count filters starting at first toward their sample poses
+  /// by their smoothing factors
+  void SmoothPoses(int first, int count);
+
+  /// Filtered pose at index, extrapolated by the prediction time for Kalman filters.
+  /// If the filter is not activated this is the last sample.
+  void GetOutputPose(int index, double rotation[4], double translation[3]) const;
+
+  /// Filtered pose of an activated filter at the output rate of the filter, to be called after each
+  /// accepted sample (see HasSample). Returns false if no output time was reached since the previous
+  /// output. Otherwise outputTimestamp is the latest output time up to the sample and the pose is
+  /// interpolated at that time between the output poses of the previous and new samples (slerp and
+  /// linear interpolation), then the next output time is scheduled.
+  /// Without output rate (or if the filter is not activated) this is the output pose of every sample,
+  /// at the time of the sample.
+  bool GetResampledOutputPose(int index, double& outputTimestamp, double rotation[4], double translation[3]);
+
+  /// Compute the weight of the new sample of a first-order low-pass filter
+  /// from the elapsed time since the previous sample and the cutoff frequency.
+  static double GetSmoothingFactor(double dt, double cutoffFrequency);
+
+  /// Conversion between homogeneous transformation matrices and poses
+  static void GetPoseFromMatrix(const double matrix[4][4], double rotation[4], double translation[3]);
+  static void GetMatrixFromPose(const double rotation[4], const double translation[3], double matrix[4][4]);
+
+  /// Rotation vector (axis * angle, in radians) of the shortest rotation from one quaternion to another,
+  /// expressed in the frame of the first one: log(conj(from) * to)
+  static void GetRotationVector(const double from[4], const double to[4], double rotationVector[3]);
+  /// Rotate a quaternion by a rotation vector expressed in its frame: rotation * exp(rotationVector).
+  /// result can be the same array as rotation.
+  static void RotateByVector(const double rotation[4], const double rotationVector[3], double result[4]);
+
+  /// Weighted average of the count poses at indices in poses, weights being indexed like poses.
+  /// The average rotation is the unit quaternion q maximizing sum(w * dot(q, qi)^2), i.e. the eigenvector
+  /// of the largest eigenvalue of M = sum(w * qi * qi^T) (F. L. Markley et al., Averaging Quaternions, 2007),
+  /// so it does not depend on the signs or order of the quaternions. It is found by power iteration from
+  /// the sign-aligned weighted sum, which converges in a few iterations for close rotations (e.g. redundant
+  /// sensors). The sign of the result is that of the first rotation. The translation is the weighted mean.
+  /// Returns false if the sum of the weights is not positive.
+  static bool GetAveragePose(const vtkSlicerTransformSmootherPoseArrays& poses, const int* indices, int count,
+                             const double* weights, double rotation[4], double translation[3]);
+
+protected:
+  /// Update of the filter at index from its new sample, dt seconds after the previous sample:
+  /// computes its smoothing factors, or its new filtered pose for filters that are not first-order
+  /// low-pass filters (their smoothing factors are then 0). Each filter mode (and order) is an update
+  /// type, chosen by SetFilterParameters. SetSamples runs one loop per update type over the filters of
+  /// that type, with the update of the type inlined, so that the per-sample update does not depend on parameters.
+  enum UpdateType
+    {
+    UpdateLowPass = 0,
+    UpdateOneEuro,
+    UpdateButterworth2,
+    UpdateButterworth4,
+    UpdateKalman,
+    UpdateType_Last // must be last
+    };
+  static int GetUpdateType(int filterMode, int filterOrder);
+  template <int Type> void UpdateFilter(int index, double dt);
+  /// Update the filters of the given type in [begin, end) that accepted a new sample
+  template <int Type> void UpdateFilters(int begin, int end);
+  /// Update of the filter at index, whatever its type
+  void UpdateFilter(int index, double dt);
+  /// Group the filters by update type, in index order
+  void UpdateFilterGroups();
+  static vtkSlicerTransformSmootherBatchKernels::RotationInterpolationFunction GetInterpolationFunction(int interpolationMode);
+
+  /// Record the new sample of the filter at index. Returns false if it is not newer than the previous one.
+  /// An activated filter that is not at its first sample must then be updated (see PendingUpdates).
+  bool AcceptSample(int index, double timestamp, const double rotation[4], const double translation[3]);
+  /// Accept the samples of the filters in [begin, end) and update them, one update type after the other
+  void SetSamplesBlock(int begin, int end, double timestamp, const vtkSlicerTransformSmootherPoseArrays& samples,
+                       const std::vector< unsigned char >& validSamples);
+  class SetSamplesFunctor;
+  friend class SetSamplesFunctor;
+
+  void Resize(int size);
+  void Move(int from, int to);
+
+  /// Restart the filter at index from its current filtered pose, at rest
+  void ResetFilterState(int index);
+
+  /// Compute the smoothing factors of the low-pass filter at index from its cutoff frequency
+  void ComputeLowPassSmoothingFactors(int index, double dt);
+
+  /// Compute the smoothing factors of the OneEuro filter at index from the speed of its
+  /// new sample relative to the current filtered pose, dt seconds after the previous sample
+  void ComputeOneEuroSmoothingFactors(int index, double dt);
+  static double GetOneEuroSmoothingFactor(double dt, double cutoffFrequency);
+
+  /// Compute the new filtered pose of the Butterworth filter of the given order (2 or 4) at index
+  /// from its new sample, dt seconds after the previous sample
+  template <int Order> void UpdateButterworthPose(int index, double dt);
+  /// Put the Butterworth filter at index at rest at its current filtered pose
+  void ResetButterworthHistory(int index);
+  /// Biquad coefficients (b0, b1, b2, a1, a2 of each section) of a Butterworth low-pass filter
+  /// of order 2 or 4
+  static void GetButterworthCoefficients(int order, double cutoffFrequency, double samplePeriod, double coefficients[10]);
+
+  /// Compute the new filtered pose and velocities of the Kalman filter at index from its
+  /// new sample, dt seconds after the previous sample
+  void UpdateKalmanPose(int index, double dt);
+  /// Set the covariances of the Kalman filter at index to their initial values
+  void ResetKalmanCovariances(int index);
+  /// Gains (position, velocity) and updated covariance of a constant-velocity Kalman filter
+  /// with position measurement. Covariances hold the position variance, position-velocity
+  /// covariance and velocity variance.
+  static void UpdateKalmanCovariance(double measurementVariance, const double predictedCovariance[3],
+                                     double gains[2], double updatedCovariance[3]);
+  /// Predict the covariance of a constant-velocity model dt seconds ahead with
+  /// piecewise constant acceleration of the given variance
+  static void PredictKalmanCovariance(double dt, double processVariance, const double covariance[3],
+                                      double predictedCovariance[3]);
+
+  // Filter parameters
+  std::vector< double > CutOffFrequencies;
+  std::vector< unsigned char > Activated;
+  std::vector< int > FilterModes;
+  std::vector< int > FilterOrders;
+  std::vector< double > MinCutOffFrequencies;
+  std::vector< double > Betas;
+  std::vector< double > PredictionTimes;
+  std::vector< double > ProcessNoises;
+  std::vector< double > MeasurementNoises;
+  std::vector< int > InterpolationModes;
+  std::vector< double > OutputRates;
+
+  // Update type and rotation interpolation of each filter, from its filter parameters
+  std::vector< unsigned char > UpdateTypes;
+  std::vector< vtkSlicerTransformSmootherBatchKernels::RotationInterpolationFunction > InterpolationFunctions;
+
+  // Filters of each update type, in index order, rebuilt by SetSamples after update types change
+  std::vector< int > FilterGroups[UpdateType_Last];
+  bool FilterGroupsModified;
+
+  // Filters that accepted a sample and are not updated yet, and the elapsed time since their previous sample
+  std::vector< unsigned char > PendingUpdates;
+  std::vector< double > SampleIntervals;
+
+  // Timestamp of the last processed input sample (in seconds)
+  std::vector< double > LastTimestamps;
+  std::vector< unsigned char > Initialized;
+
+  // Current filtered poses
+  vtkSlicerTransformSmootherPoseArrays Poses;
+
+  // Filters with an output rate: next output time, and timestamp and output pose of the previous
+  // sample to interpolate the output at the output time
+  std::vector< double > NextOutputTimes;
+  std::vector< double > PreviousTimestamps;
+  vtkSlicerTransformSmootherPoseArrays PreviousOutputPoses;
+
+  // Estimated translation velocity (mm/s) and angular velocity (rad/s, in the frame of the
+  // filtered rotation) of OneEuro and Kalman filters
+  vtkSlicerTransformSmootherVectorArrays Velocities;
+  vtkSlicerTransformSmootherVectorArrays AngularVelocities;
+
+  // Butterworth filters: estimated sample period, biquad coefficients and the parameters they
+  // were computed for, and past inputs and outputs of each section for the 3 translation and
+  // 3 rotation channels (stored with a fixed stride per filter)
+  enum
+    {
+    ButterworthCoefficientsSize = 10,
+    ButterworthHistorySize = 36
+    };
+  std::vector< double > SamplePeriods;
+  std::vector< double > ButterworthCoefficients;
+  std::vector< int > CoefficientOrders;
+  std::vector< double > CoefficientCutOffFrequencies;
+  std::vector< double > CoefficientSamplePeriods;
+  std::vector< double > ButterworthHistories;
+
+  // Kalman filters: covariance of the translation channels and of the rotation channels
+  // (position variance, position-velocity covariance, velocity variance). Channels of the
+  // same kind share parameters and samples, so they share their covariance.
+  enum
+    {
+    KalmanCovariancesSize = 6
+    };
+  std::vector< double > KalmanCovariances;
+
+  // New input samples of the current update and their smoothing factors for translation
+  // and rotation (0: filtered pose unchanged, 1: filtered pose set to the sample)
+  vtkSlicerTransformSmootherPoseArrays Samples;
+  std::vector< double > Alphas;
+  std::vector< double > RotationAlphas;
+  std::vector< unsigned char > Updated;
+};
+
+#endif
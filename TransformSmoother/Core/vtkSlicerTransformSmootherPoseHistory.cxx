@@ -0,0 +1,119 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherPoseHistory.h"
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherPoseHistory::vtkSlicerTransformSmootherPoseHistory()
+{
+  this->First = 0;
+  this->NumberOfPoses = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherPoseHistory::SetCapacity(int capacity)
+{
+  capacity = ( capacity > 0 ) ? capacity : 0;
+  if ( capacity == this->GetCapacity() )
+    {
+    return;
+    }
+  this->Timestamps.resize( capacity, 0.0 );
+  this->Poses.Resize( capacity );
+  this->Clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherPoseHistory::Clear()
+{
+  this->First = 0;
+  this->NumberOfPoses = 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherPoseHistory::AddPose(double timestamp,
+  const double rotation[4], const double translation[3])
+{
+  const int capacity = this->GetCapacity();
+  if ( capacity == 0 )
+    {
+    return false;
+    }
+  if ( this->NumberOfPoses > 0 && timestamp <= this->GetTimestamp( this->NumberOfPoses - 1 ) )
+    {
+    return false;
+    }
+
+  int bufferIndex = 0;
+  if ( this->NumberOfPoses < capacity )
+    {
+    bufferIndex = this->GetBufferIndex( this->NumberOfPoses++ );
+    }
+  else
+    {
+    // Overwrite the oldest pose
+    bufferIndex = this->First;
+    this->First = this->GetBufferIndex( 1 );
+    }
+  this->Timestamps[bufferIndex] = timestamp;
+  this->Poses.SetPose( bufferIndex, rotation, translation );
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherPoseHistory::GetPose(int index,
+  double& timestamp, double rotation[4], double translation[3]) const
+{
+  const int bufferIndex = this->GetBufferIndex( index );
+  timestamp = this->Timestamps[bufferIndex];
+  this->Poses.GetPose( bufferIndex, rotation, translation );
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherPoseHistory::FindPoses(double timestamp,
+  int& before, int& after, double& weight) const
+{
+  if ( this->NumberOfPoses == 0
+    || timestamp < this->GetTimestamp( 0 ) || timestamp > this->GetTimestamp( this->NumberOfPoses - 1 ) )
+    {
+    return false;
+    }
+
+  // Last pose at or before timestamp
+  int low = 0;
+  int high = this->NumberOfPoses - 1;
+  while ( low < high )
+    {
+    const int middle = ( low + high + 1 ) / 2;
+    if ( this->GetTimestamp( middle ) <= timestamp )
+      {
+      low = middle;
+      }
+    else
+      {
+      high = middle - 1;
+      }
+    }
+
+  before = low;
+  after = ( low + 1 < this->NumberOfPoses ) ? low + 1 : low;
+  const double beforeTimestamp = this->GetTimestamp( before );
+  const double afterTimestamp = this->GetTimestamp( after );
+  weight = ( afterTimestamp > beforeTimestamp ) ? ( timestamp - beforeTimestamp ) / ( afterTimestamp - beforeTimestamp ) : 0.0;
+  return true;
+}
@@ -0,0 +1,78 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherPoseHistory - timestamped poses of a filter
+// .SECTION Description
+// Fixed capacity ring buffer of the latest timestamped poses (rotation as unit quaternion and
+// translation), in time order. When it is full the oldest pose is overwritten. Storage is allocated
+// by SetCapacity only. FindPoses locates the poses around a timestamp by binary search, so
+// that poses can be looked up at any time within the history.
+
+#ifndef __vtkSlicerTransformSmootherPoseHistory_h
+#define __vtkSlicerTransformSmootherPoseHistory_h
+
+#include "vtkSlicerTransformSmootherModuleCoreExport.h"
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherFilterBank.h"
+
+// STD includes
+#include <vector>
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT vtkSlicerTransformSmootherPoseHistory
+{
+public:
+  vtkSlicerTransformSmootherPoseHistory();
+
+  /// Maximum number of poses. Poses are discarded if the capacity changes.
+  void SetCapacity(int capacity);
+  int GetCapacity() const { return static_cast<int>( this->Timestamps.size() ); }
+
+  int GetNumberOfPoses() const { return this->NumberOfPoses; }
+
+  /// Discard all poses
+  void Clear();
+
+  /// Add the pose at timestamp (in seconds), replacing the oldest pose if the history is full.
+  /// Returns false if the pose is not newer than the latest one, it is then ignored.
+  bool AddPose(double timestamp, const double rotation[4], const double translation[3]);
+
+  /// Pose at index, 0 being the oldest pose
+  void GetPose(int index, double& timestamp, double rotation[4], double translation[3]) const;
+  double GetTimestamp(int index) const { return this->Timestamps[this->GetBufferIndex( index )]; }
+
+  /// Find the poses just before and after timestamp (at or before, and after), and the weight of the
+  /// pose after (between 0 and 1) for interpolating at timestamp. Returns false if timestamp is outside
+  /// the time range of the history.
+  bool FindPoses(double timestamp, int& before, int& after, double& weight) const;
+
+protected:
+  int GetBufferIndex(int index) const
+  {
+    const int bufferIndex = this->First + index;
+    return ( bufferIndex < this->GetCapacity() ) ? bufferIndex : bufferIndex - this->GetCapacity();
+  }
+
+  std::vector< double > Timestamps;
+  vtkSlicerTransformSmootherPoseArrays Poses;
+  // Position of the oldest pose in the buffer
+  int First;
+  int NumberOfPoses;
+};
+
+#endif
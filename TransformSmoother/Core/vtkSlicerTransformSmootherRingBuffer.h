@@ -0,0 +1,105 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherRingBuffer - lock-free single-producer single-consumer queue
+// .SECTION Description
+// Fixed capacity FIFO queue to hand items over from one thread (the producer) to another
+// (the consumer) without locks. Items are written and read in place: the producer fills
+// the item returned by BeginPush then calls EndPush, the consumer reads the item returned
+// by Front then calls Pop. Storage is allocated once at construction.
+//
+// Only one thread may push and only one thread may pop at any time.
+
+#ifndef __vtkSlicerTransformSmootherRingBuffer_h
+#define __vtkSlicerTransformSmootherRingBuffer_h
+
+// VTK includes
+#include <vtkAtomic.h>
+
+// STD includes
+#include <cstddef>
+#include <vector>
+
+template <class T>
+class vtkSlicerTransformSmootherRingBuffer
+{
+public:
+  /// Create a queue that can hold up to capacity items
+  explicit vtkSlicerTransformSmootherRingBuffer(int capacity)
+    : Items( capacity + 1 )
+  {
+    this->Head = 0;
+    this->Tail = 0;
+  }
+
+  int GetCapacity() const { return static_cast<int>( this->Items.size() ) - 1; }
+
+  /// Consumer or producer: true if there is no item to pop (may change right after the call)
+  bool IsEmpty() const { return this->Head.Load() == this->Tail.Load(); }
+
+  /// Producer only: item to fill before calling EndPush, NULL if the queue is full
+  T* BeginPush()
+  {
+    const int tail = this->Tail.Load();
+    if ( this->GetNext( tail ) == this->Head.Load() )
+      {
+      return NULL;
+      }
+    return &this->Items[tail];
+  }
+
+  /// Producer only: make the item returned by BeginPush available to the consumer
+  void EndPush()
+  {
+    this->Tail.Store( this->GetNext( this->Tail.Load() ) );
+  }
+
+  /// Consumer only: oldest item, NULL if the queue is empty
+  const T* Front() const
+  {
+    const int head = this->Head.Load();
+    if ( head == this->Tail.Load() )
+      {
+      return NULL;
+      }
+    return &this->Items[head];
+  }
+
+  /// Consumer only: release the item returned by Front, so that the producer can reuse it
+  void Pop()
+  {
+    this->Head.Store( this->GetNext( this->Head.Load() ) );
+  }
+
+private:
+  int GetNext(int position) const
+  {
+    return ( position + 1 < static_cast<int>( this->Items.size() ) ) ? position + 1 : 0;
+  }
+
+  // One slot is kept free to distinguish a full queue from an empty one
+  std::vector<T> Items;
+  // Next item to read, only modified by the consumer
+  vtkAtomic<int> Head;
+  // Next item to write, only modified by the producer
+  vtkAtomic<int> Tail;
+
+  vtkSlicerTransformSmootherRingBuffer(const vtkSlicerTransformSmootherRingBuffer&); // Not implemented
+  void operator=(const vtkSlicerTransformSmootherRingBuffer&); // Not implemented
+};
+
+#endif
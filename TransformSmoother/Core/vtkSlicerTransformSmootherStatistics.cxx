@@ -0,0 +1,126 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherStatistics.h"
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+// Lower bound of the first bin of duration histograms (in seconds)
+const double MinimumDuration = 1e-7;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherStatistics::DurationHistogram::DurationHistogram()
+{
+  this->Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherStatistics::DurationHistogram::Reset()
+{
+  for (int i = 0; i < NumberOfBins; ++i)
+    {
+    this->Counts[i] = 0;
+    }
+  this->NumberOfValues = 0;
+  this->Maximum = 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherStatistics::DurationHistogram::Add(double duration)
+{
+  int bin = 0;
+  if ( duration > MinimumDuration )
+    {
+    bin = static_cast<int>( BinsPerDecade * log10( duration / MinimumDuration ) );
+    bin = ( bin < NumberOfBins ) ? bin : NumberOfBins - 1;
+    }
+  ++this->Counts[bin];
+  ++this->NumberOfValues;
+  if ( duration > this->Maximum )
+    {
+    this->Maximum = duration;
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerTransformSmootherStatistics::DurationHistogram::GetPercentile(double fraction) const
+{
+  if ( this->NumberOfValues == 0 )
+    {
+    return 0.0;
+    }
+
+  // Rank of the value in the sorted values, then bin containing that rank
+  fraction = ( fraction < 0.0 ) ? 0.0 : ( fraction > 1.0 ? 1.0 : fraction );
+  unsigned long rank = static_cast<unsigned long>( ceil( fraction * this->NumberOfValues ) );
+  rank = ( rank > 0 ) ? rank : 1;
+  unsigned long count = 0;
+  for (int bin = 0; bin < NumberOfBins; ++bin)
+    {
+    count += this->Counts[bin];
+    if ( count >= rank )
+      {
+      // Geometric center of the bin, not more than the largest value
+      const double center = MinimumDuration * pow( 10.0, ( bin + 0.5 ) / BinsPerDecade );
+      return ( center < this->Maximum ) ? center : this->Maximum;
+      }
+    }
+  return this->Maximum;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherStatistics::vtkSlicerTransformSmootherStatistics()
+{
+  this->NumberOfDroppedSamples = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherStatistics::Reset()
+{
+  this->NumberOfDroppedSamples = 0;
+  this->FilterTimes.Reset();
+  this->Latencies.Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherStatistics::AddProcessedSample(double filterTime, double latency)
+{
+  this->FilterTimes.Add( filterTime );
+  this->Latencies.Add( latency );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherStatistics::AddDroppedSample()
+{
+  ++this->NumberOfDroppedSamples;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherStatistics::Print(std::ostream& os) const
+{
+  os << "Processed samples: " << this->GetNumberOfProcessedSamples()
+     << ", dropped samples: " << this->GetNumberOfDroppedSamples()
+     << ", filter time p50/p99: " << this->GetFilterTimePercentile( 0.5 ) * 1e6
+     << "/" << this->GetFilterTimePercentile( 0.99 ) * 1e6 << " us"
+     << ", latency p50/p99: " << this->GetLatencyPercentile( 0.5 ) * 1e3
+     << "/" << this->GetLatencyPercentile( 0.99 ) * 1e3 << " ms";
+}
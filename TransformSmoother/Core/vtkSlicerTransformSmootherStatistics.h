@@ -0,0 +1,91 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherStatistics - execution statistics of a pose filter
+// .SECTION Description
+// Counters of processed and dropped samples, and histograms of the filter execution time
+// and of the input-to-output latency, from which percentiles are computed.
+// Histograms have fixed logarithmic bins (12 per decade, from 100 ns to 10 s), so that
+// adding a value is a constant-time operation without memory allocation. Percentiles
+// are accurate to the bin width (about 20%).
+
+#ifndef __vtkSlicerTransformSmootherStatistics_h
+#define __vtkSlicerTransformSmootherStatistics_h
+
+#include "vtkSlicerTransformSmootherModuleCoreExport.h"
+
+// STD includes
+#include <iostream>
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT vtkSlicerTransformSmootherStatistics
+{
+public:
+  /// Histogram of durations (in seconds) with logarithmic bins
+  class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT DurationHistogram
+  {
+  public:
+    DurationHistogram();
+    void Reset();
+    void Add(double duration);
+    unsigned long GetNumberOfValues() const { return this->NumberOfValues; }
+    /// Duration below which the given fraction (between 0 and 1) of the values are.
+    /// Returns 0 if the histogram is empty.
+    double GetPercentile(double fraction) const;
+    double GetMaximum() const { return this->Maximum; }
+
+  private:
+    enum
+      {
+      BinsPerDecade = 12,
+      NumberOfBins = 8 * BinsPerDecade
+      };
+    unsigned long Counts[NumberOfBins];
+    unsigned long NumberOfValues;
+    double Maximum;
+  };
+
+  vtkSlicerTransformSmootherStatistics();
+
+  void Reset();
+
+  /// Record a sample that was filtered in filterTime seconds, with its output available
+  /// latency seconds after its acquisition
+  void AddProcessedSample(double filterTime, double latency);
+  /// Record a sample that could not be filtered (e.g. not newer than the previous one)
+  void AddDroppedSample();
+
+  unsigned long GetNumberOfProcessedSamples() const { return this->FilterTimes.GetNumberOfValues(); }
+  unsigned long GetNumberOfDroppedSamples() const { return this->NumberOfDroppedSamples; }
+
+  /// Filter execution time and input-to-output latency percentiles (in seconds),
+  /// e.g. GetFilterTimePercentile(0.99) for p99
+  double GetFilterTimePercentile(double fraction) const { return this->FilterTimes.GetPercentile( fraction ); }
+  double GetLatencyPercentile(double fraction) const { return this->Latencies.GetPercentile( fraction ); }
+
+  const DurationHistogram& GetFilterTimes() const { return this->FilterTimes; }
+  const DurationHistogram& GetLatencies() const { return this->Latencies; }
+
+  void Print(std::ostream& os) const;
+
+private:
+  unsigned long NumberOfDroppedSamples;
+  DurationHistogram FilterTimes;
+  DurationHistogram Latencies;
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherTrajectoryFormat - binary trajectory file layout
+// .SECTION Description
+// A trajectory file stores the input samples of a filter, so that they can be replayed later.
+// It is a 64 byte header followed by packed fixed-size records, one per sample, in the order
+// they were acquired. Values are stored in the byte order of the recording machine, which is
+// identified by the ByteOrderMark field of the header.
+//
+// Records only contain doubles, so they have no padding and can be accessed in place in a
+// memory-mapped file (see vtkSlicerTransformSmootherTrajectoryReader).
+
+#ifndef __vtkSlicerTransformSmootherTrajectoryFormat_h
+#define __vtkSlicerTransformSmootherTrajectoryFormat_h
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <cstring>
+
+struct vtkSlicerTransformSmootherTrajectoryFormat
+{
+  enum
+    {
+    Version = 1,
+    ByteOrderMark = 0x01020304
+    };
+
+  struct Header
+  {
+    char Magic[8]; // "TSMTRAJ" followed by a null character
+    vtkTypeUInt32 Version;
+    vtkTypeUInt32 ByteOrderMark;
+    vtkTypeUInt32 HeaderSize; // in bytes, offset of the first record
+    vtkTypeUInt32 RecordSize; // in bytes
+    /// Number of records, written when the recording is complete.
+    /// 0 if the recording was interrupted, the number of records is then deduced from the file size.
+    vtkTypeUInt64 NumberOfRecords;
+    char Reserved[32];
+  };
+
+  /// Input sample: acquisition timestamp (in seconds), rotation quaternion (w, x, y, z)
+  /// and translation (in mm)
+  struct Record
+  {
+    double Timestamp;
+    double Rotation[4];
+    double Translation[3];
+  };
+
+  static void InitializeHeader(Header& header)
+  {
+    memset( &header, 0, sizeof( Header ) );
+    memcpy( header.Magic, "TSMTRAJ", 8 );
+    header.Version = Version;
+    header.ByteOrderMark = ByteOrderMark;
+    header.HeaderSize = sizeof( Header );
+    header.RecordSize = sizeof( Record );
+  }
+
+  /// Check that the header describes a file that can be read on this machine
+  static bool IsValidHeader(const Header& header)
+  {
+    return memcmp( header.Magic, "TSMTRAJ", 8 ) == 0
+      && header.Version == Version
+      && header.ByteOrderMark == ByteOrderMark
+      && header.HeaderSize == sizeof( Header )
+      && header.RecordSize == sizeof( Record );
+  }
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherTrajectoryReader.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherTrajectoryReader::vtkSlicerTransformSmootherTrajectoryReader()
+{
+  this->MappedData = NULL;
+  this->MappedSize = 0;
+#if defined(_WIN32)
+  this->FileHandle = INVALID_HANDLE_VALUE;
+  this->MappingHandle = NULL;
+#endif
+  this->Records = NULL;
+  this->NumberOfRecords = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherTrajectoryReader::~vtkSlicerTransformSmootherTrajectoryReader()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherTrajectoryReader::Open(const char* filename)
+{
+  this->Close();
+  if ( filename == NULL )
+    {
+    return false;
+    }
+
+  // Map the whole file, read-only
+  vtkTypeUInt64 fileSize = 0;
+#if defined(_WIN32)
+  this->FileHandle = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+  if ( this->FileHandle == INVALID_HANDLE_VALUE )
+    {
+    return false;
+    }
+  LARGE_INTEGER size;
+  if ( GetFileSizeEx( this->FileHandle, &size ) )
+    {
+    fileSize = static_cast<vtkTypeUInt64>( size.QuadPart );
+    }
+  if ( fileSize >= sizeof( vtkSlicerTransformSmootherTrajectoryFormat::Header ) && fileSize <= static_cast<size_t>( -1 ) )
+    {
+    this->MappingHandle = CreateFileMappingA( this->FileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+    }
+  if ( this->MappingHandle != NULL )
+    {
+    this->MappedData = MapViewOfFile( this->MappingHandle, FILE_MAP_READ, 0, 0, 0 );
+    }
+#else
+  const int fileDescriptor = open( filename, O_RDONLY );
+  if ( fileDescriptor < 0 )
+    {
+    return false;
+    }
+  struct stat status;
+  if ( fstat( fileDescriptor, &status ) == 0 )
+    {
+    fileSize = static_cast<vtkTypeUInt64>( status.st_size );
+    }
+  if ( fileSize >= sizeof( vtkSlicerTransformSmootherTrajectoryFormat::Header ) && fileSize <= static_cast<size_t>( -1 ) )
+    {
+    void* data = mmap( NULL, static_cast<size_t>( fileSize ), PROT_READ, MAP_SHARED, fileDescriptor, 0 );
+    if ( data != MAP_FAILED )
+      {
+      this->MappedData = data;
+      // Records are usually replayed in order
+      madvise( data, static_cast<size_t>( fileSize ), MADV_SEQUENTIAL );
+      }
+    }
+  // The mapping stays valid after the file is closed
+  close( fileDescriptor );
+#endif
+  if ( this->MappedData == NULL )
+    {
+    this->Close();
+    return false;
+    }
+  this->MappedSize = static_cast<size_t>( fileSize );
+
+  const vtkSlicerTransformSmootherTrajectoryFormat::Header* header =
+    static_cast< const vtkSlicerTransformSmootherTrajectoryFormat::Header* >( this->MappedData );
+  if ( !vtkSlicerTransformSmootherTrajectoryFormat::IsValidHeader( *header ) )
+    {
+    this->Close();
+    return false;
+    }
+
+  // Records of an interrupted recording are all kept, except a partially written last one
+  const vtkTypeUInt64 numberOfStoredRecords = ( fileSize - header->HeaderSize ) / header->RecordSize;
+  this->NumberOfRecords = ( header->NumberOfRecords > 0 && header->NumberOfRecords <= numberOfStoredRecords ) ?
+    header->NumberOfRecords : numberOfStoredRecords;
+  this->Records = reinterpret_cast< const vtkSlicerTransformSmootherTrajectoryFormat::Record* >(
+    static_cast< const char* >( this->MappedData ) + header->HeaderSize );
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherTrajectoryReader::Close()
+{
+#if defined(_WIN32)
+  if ( this->MappedData != NULL )
+    {
+    UnmapViewOfFile( this->MappedData );
+    }
+  if ( this->MappingHandle != NULL )
+    {
+    CloseHandle( this->MappingHandle );
+    }
+  if ( this->FileHandle != INVALID_HANDLE_VALUE )
+    {
+    CloseHandle( this->FileHandle );
+    }
+  this->MappingHandle = NULL;
+  this->FileHandle = INVALID_HANDLE_VALUE;
+#else
+  if ( this->MappedData != NULL )
+    {
+    munmap( this->MappedData, this->MappedSize );
+    }
+#endif
+  this->MappedData = NULL;
+  this->MappedSize = 0;
+  this->Records = NULL;
+  this->NumberOfRecords = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherTrajectoryReader::GetSample(vtkTypeUInt64 index,
+  double& timestamp, double rotation[4], double translation[3]) const
+{
+  const vtkSlicerTransformSmootherTrajectoryFormat::Record& record = this->Records[index];
+  timestamp = record.Timestamp;
+  rotation[0] = record.Rotation[0];
+  rotation[1] = record.Rotation[1];
+  rotation[2] = record.Rotation[2];
+  rotation[3] = record.Rotation[3];
+  translation[0] = record.Translation[0];
+  translation[1] = record.Translation[1];
+  translation[2] = record.Translation[2];
+}
@@ -0,0 +1,73 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherTrajectoryReader - memory-mapped access to a trajectory file
+// .SECTION Description
+// Maps a binary trajectory file (see vtkSlicerTransformSmootherTrajectoryFormat) in memory
+// and gives direct access to its records, without copying them. Pages are loaded by the
+// operating system as records are accessed, so files larger than the physical memory can be
+// read (on 64-bit systems).
+
+#ifndef __vtkSlicerTransformSmootherTrajectoryReader_h
+#define __vtkSlicerTransformSmootherTrajectoryReader_h
+
+#include "vtkSlicerTransformSmootherModuleCoreExport.h"
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherTrajectoryFormat.h"
+
+// STD includes
+#include <cstddef>
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT vtkSlicerTransformSmootherTrajectoryReader
+{
+public:
+  vtkSlicerTransformSmootherTrajectoryReader();
+  /// Unmap the file if it is open
+  ~vtkSlicerTransformSmootherTrajectoryReader();
+
+  /// Map a trajectory file in memory. Returns false if the file cannot be mapped
+  /// or is not a trajectory file that can be read on this machine.
+  bool Open(const char* filename);
+  void Close();
+  bool IsOpen() const { return this->MappedData != NULL; }
+
+  vtkTypeUInt64 GetNumberOfRecords() const { return this->NumberOfRecords; }
+
+  /// Records of the file, in acquisition order. Valid until the file is closed.
+  const vtkSlicerTransformSmootherTrajectoryFormat::Record* GetRecords() const { return this->Records; }
+
+  /// Get the sample stored in a record
+  void GetSample(vtkTypeUInt64 index, double& timestamp, double rotation[4], double translation[3]) const;
+
+protected:
+  void* MappedData;
+  size_t MappedSize;
+#if defined(_WIN32)
+  void* FileHandle;
+  void* MappingHandle;
+#endif
+  const vtkSlicerTransformSmootherTrajectoryFormat::Record* Records;
+  vtkTypeUInt64 NumberOfRecords;
+
+private:
+  vtkSlicerTransformSmootherTrajectoryReader(const vtkSlicerTransformSmootherTrajectoryReader&); // Not implemented
+  void operator=(const vtkSlicerTransformSmootherTrajectoryReader&); // Not implemented
+};
+
+#endif
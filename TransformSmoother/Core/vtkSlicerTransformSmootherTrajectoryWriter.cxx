@@ -0,0 +1,139 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherTrajectoryWriter.h"
+
+namespace
+{
+// 1 MB of records, a few seconds of samples of hundreds of tools at tracker rates
+const size_t BufferSize = 16384;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherTrajectoryWriter::vtkSlicerTransformSmootherTrajectoryWriter()
+{
+  this->File = NULL;
+  this->NumberOfRecords = 0;
+  this->NumberOfBufferedRecords = 0;
+  this->WriteFailed = false;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherTrajectoryWriter::~vtkSlicerTransformSmootherTrajectoryWriter()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherTrajectoryWriter::Open(const char* filename)
+{
+  this->Close();
+  if ( filename == NULL )
+    {
+    return false;
+    }
+  this->File = fopen( filename, "wb" );
+  if ( this->File == NULL )
+    {
+    return false;
+    }
+  // Records are buffered here, in large blocks
+  setvbuf( this->File, NULL, _IONBF, 0 );
+
+  // The number of records is unknown until the file is closed
+  vtkSlicerTransformSmootherTrajectoryFormat::Header header;
+  vtkSlicerTransformSmootherTrajectoryFormat::InitializeHeader( header );
+  if ( fwrite( &header, sizeof( header ), 1, this->File ) != 1 )
+    {
+    fclose( this->File );
+    this->File = NULL;
+    return false;
+    }
+
+  this->Buffer.resize( BufferSize );
+  this->NumberOfRecords = 0;
+  this->NumberOfBufferedRecords = 0;
+  this->WriteFailed = false;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherTrajectoryWriter::WriteSample(double timestamp,
+  const double rotation[4], const double translation[3])
+{
+  if ( this->File == NULL || this->WriteFailed )
+    {
+    return false;
+    }
+  if ( this->NumberOfBufferedRecords == this->Buffer.size() && !this->Flush() )
+    {
+    return false;
+    }
+
+  vtkSlicerTransformSmootherTrajectoryFormat::Record& record = this->Buffer[this->NumberOfBufferedRecords++];
+  record.Timestamp = timestamp;
+  record.Rotation[0] = rotation[0];
+  record.Rotation[1] = rotation[1];
+  record.Rotation[2] = rotation[2];
+  record.Rotation[3] = rotation[3];
+  record.Translation[0] = translation[0];
+  record.Translation[1] = translation[1];
+  record.Translation[2] = translation[2];
+  ++this->NumberOfRecords;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherTrajectoryWriter::Flush()
+{
+  if ( this->NumberOfBufferedRecords > 0
+    && fwrite( &this->Buffer[0], sizeof( vtkSlicerTransformSmootherTrajectoryFormat::Record ),
+               this->NumberOfBufferedRecords, this->File ) != this->NumberOfBufferedRecords )
+    {
+    this->WriteFailed = true;
+    }
+  this->NumberOfBufferedRecords = 0;
+  return !this->WriteFailed;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherTrajectoryWriter::Close()
+{
+  if ( this->File == NULL )
+    {
+    return false;
+    }
+
+  bool success = this->Flush();
+  if ( success )
+    {
+    // Complete the header. An interrupted recording keeps 0 records in the header,
+    // the reader then uses the file size.
+    vtkSlicerTransformSmootherTrajectoryFormat::Header header;
+    vtkSlicerTransformSmootherTrajectoryFormat::InitializeHeader( header );
+    header.NumberOfRecords = this->NumberOfRecords;
+    success = ( fseek( this->File, 0, SEEK_SET ) == 0 && fwrite( &header, sizeof( header ), 1, this->File ) == 1 );
+    }
+  success = ( fclose( this->File ) == 0 ) && success;
+  this->File = NULL;
+
+  // Release the buffer
+  std::vector< vtkSlicerTransformSmootherTrajectoryFormat::Record >().swap( this->Buffer );
+  this->NumberOfBufferedRecords = 0;
+  return success;
+}
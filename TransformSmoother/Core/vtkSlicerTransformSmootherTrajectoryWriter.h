@@ -0,0 +1,72 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherTrajectoryWriter - records input samples to a trajectory file
+// .SECTION Description
+// Appends samples to a binary trajectory file (see vtkSlicerTransformSmootherTrajectoryFormat).
+// Records are collected in a large buffer that is written to the file when it is full, so that
+// recording a sample is a copy of 64 bytes most of the time. Memory is allocated by Open only.
+
+#ifndef __vtkSlicerTransformSmootherTrajectoryWriter_h
+#define __vtkSlicerTransformSmootherTrajectoryWriter_h
+
+#include "vtkSlicerTransformSmootherModuleCoreExport.h"
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherTrajectoryFormat.h"
+
+// STD includes
+#include <cstdio>
+#include <vector>
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT vtkSlicerTransformSmootherTrajectoryWriter
+{
+public:
+  vtkSlicerTransformSmootherTrajectoryWriter();
+  /// Close the file if it is open
+  ~vtkSlicerTransformSmootherTrajectoryWriter();
+
+  /// Create (or overwrite) a trajectory file. Returns false if the file cannot be written.
+  bool Open(const char* filename);
+  bool IsOpen() const { return this->File != NULL; }
+
+  /// Append a sample. Returns false if the file is not open or cannot be written.
+  bool WriteSample(double timestamp, const double rotation[4], const double translation[3]);
+
+  /// Write the buffered samples and the number of records, then close the file.
+  /// Returns false if the file could not be completely written.
+  bool Close();
+
+  /// Number of samples written since the file was opened
+  vtkTypeUInt64 GetNumberOfRecords() const { return this->NumberOfRecords; }
+
+protected:
+  bool Flush();
+
+  FILE* File;
+  vtkTypeUInt64 NumberOfRecords;
+  std::vector< vtkSlicerTransformSmootherTrajectoryFormat::Record > Buffer;
+  size_t NumberOfBufferedRecords;
+  bool WriteFailed;
+
+private:
+  vtkSlicerTransformSmootherTrajectoryWriter(const vtkSlicerTransformSmootherTrajectoryWriter&); // Not implemented
+  void operator=(const vtkSlicerTransformSmootherTrajectoryWriter&); // Not implemented
+};
+
+#endif
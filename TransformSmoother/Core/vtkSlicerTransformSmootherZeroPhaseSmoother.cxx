@@ -0,0 +1,250 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherZeroPhaseSmoother.h"
+
+namespace
+{
+//----------------------------------------------------------------------------
+template <class T>
+void EraseFront(std::vector<T>& values, int count)
+{
+  values.erase( values.begin(), values.begin() + count );
+}
+
+//----------------------------------------------------------------------------
+void EraseFront(vtkSlicerTransformSmootherPoseArrays& poses, int count)
+{
+  EraseFront( poses.RotationW, count );
+  EraseFront( poses.RotationX, count );
+  EraseFront( poses.RotationY, count );
+  EraseFront( poses.RotationZ, count );
+  EraseFront( poses.TranslationX, count );
+  EraseFront( poses.TranslationY, count );
+  EraseFront( poses.TranslationZ, count );
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherZeroPhaseSmoother::vtkSlicerTransformSmootherZeroPhaseSmoother()
+{
+  this->CutOffFrequency = 7.5;
+  this->InterpolationMode = vtkSlicerTransformSmootherFilterBank::InterpolationPolynomialSlerp;
+  this->ChunkSize = 4096;
+  this->Tolerance = 1e-6;
+  this->MaximumLookahead = 65536;
+  this->Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::SetCutOffFrequency(double cutoffFrequency)
+{
+  this->CutOffFrequency = cutoffFrequency;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::SetInterpolationMode(int mode)
+{
+  this->InterpolationMode = mode;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::SetChunkSize(int chunkSize)
+{
+  this->ChunkSize = ( chunkSize > 1 ) ? chunkSize : 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::SetTolerance(double tolerance)
+{
+  this->Tolerance = tolerance;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::SetMaximumLookahead(int maximumLookahead)
+{
+  this->MaximumLookahead = ( maximumLookahead > 1 ) ? maximumLookahead : 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::Reset()
+{
+  this->ForwardFilter.RemoveAllFilters();
+  this->Timestamps.clear();
+  this->ForwardPoses.Resize( 0 );
+  this->SmoothedPoses.Resize( 0 );
+  this->NumberOfSmoothedSamples = 0;
+  this->NumberOfPoppedSamples = 0;
+  this->LookaheadWeight = 1.0;
+  this->Finished = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherZeroPhaseSmoother::AddSample(double timestamp,
+  const double rotation[4], const double translation[3])
+{
+  if ( this->Finished )
+    {
+    return false;
+    }
+  if ( this->ForwardFilter.GetNumberOfFilters() == 0 )
+    {
+    this->InitializeFilter( this->ForwardFilter );
+    }
+
+  // Forward pass
+  if ( !this->ForwardFilter.SetSample( 0, timestamp, rotation, translation ) )
+    {
+    return false;
+    }
+  const int index = static_cast<int>( this->Timestamps.size() );
+  double forwardRotation[4];
+  double forwardTranslation[3];
+  this->ForwardFilter.GetOutputPose( 0, forwardRotation, forwardTranslation );
+  this->Timestamps.push_back( timestamp );
+  this->ForwardPoses.Resize( index + 1 );
+  this->ForwardPoses.SetPose( index, forwardRotation, forwardTranslation );
+  this->SmoothedPoses.Resize( index + 1 );
+
+  if ( this->NumberOfSmoothedSamples == 0 )
+    {
+    // Extend the lookahead of the next chunk
+    if ( index >= this->ChunkSize )
+      {
+      this->LookaheadWeight *= 1.0 - vtkSlicerTransformSmootherFilterBank::GetSmoothingFactor(
+        timestamp - this->Timestamps[index - 1], this->CutOffFrequency );
+      }
+    this->UpdateBuffer();
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::Finish()
+{
+  this->Finished = true;
+  this->UpdateBuffer();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherZeroPhaseSmoother::PopSample(double& timestamp,
+  double rotation[4], double translation[3])
+{
+  if ( this->NumberOfPoppedSamples >= this->NumberOfSmoothedSamples )
+    {
+    this->UpdateBuffer();
+    if ( this->NumberOfPoppedSamples >= this->NumberOfSmoothedSamples )
+      {
+      return false;
+      }
+    }
+
+  const int index = this->NumberOfPoppedSamples++;
+  timestamp = this->Timestamps[index];
+  this->SmoothedPoses.GetPose( index, rotation, translation );
+
+  if ( this->NumberOfPoppedSamples == this->NumberOfSmoothedSamples )
+    {
+    this->UpdateBuffer();
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::UpdateBuffer()
+{
+  if ( this->NumberOfSmoothedSamples > 0 )
+    {
+    if ( this->NumberOfPoppedSamples < this->NumberOfSmoothedSamples )
+      {
+      // Smoothed samples are still to be retrieved
+      return;
+      }
+    // Keep only the lookahead, it is the beginning of the next chunk
+    EraseFront( this->Timestamps, this->NumberOfSmoothedSamples );
+    EraseFront( this->ForwardPoses, this->NumberOfSmoothedSamples );
+    EraseFront( this->SmoothedPoses, this->NumberOfSmoothedSamples );
+    this->NumberOfSmoothedSamples = 0;
+    this->NumberOfPoppedSamples = 0;
+    this->ComputeLookaheadWeight();
+    }
+
+  const int numberOfSamples = static_cast<int>( this->Timestamps.size() );
+  if ( numberOfSamples == 0 )
+    {
+    return;
+    }
+  if ( this->Finished )
+    {
+    // The backward pass starts from the end of the trajectory, no truncation
+    this->SmoothBufferedSamples( numberOfSamples );
+    }
+  else if ( numberOfSamples > this->ChunkSize
+    && ( this->LookaheadWeight <= this->Tolerance || numberOfSamples - this->ChunkSize >= this->MaximumLookahead ) )
+    {
+    this->SmoothBufferedSamples( this->ChunkSize );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::SmoothBufferedSamples(int count)
+{
+  // Backward pass over the forward output. Timestamps are negated so that they increase.
+  this->InitializeFilter( this->BackwardFilter );
+  const int numberOfSamples = static_cast<int>( this->Timestamps.size() );
+  double rotation[4];
+  double translation[3];
+  for (int i = numberOfSamples - 1; i >= 0; --i)
+    {
+    this->ForwardPoses.GetPose( i, rotation, translation );
+    this->BackwardFilter.SetSample( 0, -this->Timestamps[i], rotation, translation );
+    if ( i < count )
+      {
+      this->BackwardFilter.GetOutputPose( 0, rotation, translation );
+      this->SmoothedPoses.SetPose( i, rotation, translation );
+      }
+    }
+  this->NumberOfSmoothedSamples = count;
+  this->NumberOfPoppedSamples = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::ComputeLookaheadWeight()
+{
+  // Each backward step keeps (1 - alpha) of the state coming from the later samples
+  this->LookaheadWeight = 1.0;
+  const int numberOfSamples = static_cast<int>( this->Timestamps.size() );
+  for (int i = this->ChunkSize; i < numberOfSamples; ++i)
+    {
+    this->LookaheadWeight *= 1.0 - vtkSlicerTransformSmootherFilterBank::GetSmoothingFactor(
+      this->Timestamps[i] - this->Timestamps[i - 1], this->CutOffFrequency );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherZeroPhaseSmoother::InitializeFilter(vtkSlicerTransformSmootherFilterBank& filter) const
+{
+  filter.RemoveAllFilters();
+  filter.AddFilter();
+  vtkSlicerTransformSmootherFilterBank::FilterParameters parameters;
+  parameters.Activated = true;
+  parameters.FilterMode = vtkSlicerTransformSmootherFilterBank::FilterLowPass;
+  parameters.CutOffFrequency = this->CutOffFrequency;
+  parameters.InterpolationMode = this->InterpolationMode;
+  filter.SetFilterParameters( 0, parameters );
+}
@@ -0,0 +1,117 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerTransformSmootherZeroPhaseSmoother - offline zero-phase smoothing of a trajectory
+// .SECTION Description
+// Smooths a recorded pose trajectory without phase lag by running the low-pass filter of the
+// filter bank forwards in time, then backwards over the forward output (forward-backward filtering).
+//
+// The trajectory is streamed: samples are added in time order with AddSample and smoothed samples
+// are retrieved in the same order with PopSample. The forward pass is causal. The backward pass is
+// run on chunks of ChunkSize samples, starting from a lookahead past the end of the chunk instead
+// of the end of the trajectory. The lookahead is extended until the weight that the backward pass
+// still gives to the samples beyond it at the end of the chunk, the product of (1 - alpha) over the
+// lookahead samples, is at most Tolerance, or it reaches MaximumLookahead samples. Memory is
+// therefore bounded by ChunkSize + MaximumLookahead samples, whatever the length of the trajectory;
+// a trajectory shorter than a chunk is smoothed exactly.
+
+#ifndef __vtkSlicerTransformSmootherZeroPhaseSmoother_h
+#define __vtkSlicerTransformSmootherZeroPhaseSmoother_h
+
+#include "vtkSlicerTransformSmootherModuleCoreExport.h"
+
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherFilterBank.h"
+
+// STD includes
+#include <vector>
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_TRANSFORMSMOOTHER_MODULE_CORE_EXPORT vtkSlicerTransformSmootherZeroPhaseSmoother
+{
+public:
+  vtkSlicerTransformSmootherZeroPhaseSmoother();
+
+  /// Cutoff frequency (in Hz) of the low-pass filter applied in each direction (7.5 by default).
+  /// The magnitude response of the forward-backward filter is the square of the low-pass one.
+  void SetCutOffFrequency(double cutoffFrequency);
+  double GetCutOffFrequency() const { return this->CutOffFrequency; }
+
+  /// Interpolation of rotations (see vtkSlicerTransformSmootherFilterBank::InterpolationModeType)
+  void SetInterpolationMode(int mode);
+  int GetInterpolationMode() const { return this->InterpolationMode; }
+
+  /// Number of samples smoothed by each backward pass (4096 by default)
+  void SetChunkSize(int chunkSize);
+  int GetChunkSize() const { return this->ChunkSize; }
+
+  /// Maximum weight of the samples past the lookahead in the smoothed poses, as a fraction of 1 (1e-6 by default)
+  void SetTolerance(double tolerance);
+  double GetTolerance() const { return this->Tolerance; }
+
+  /// Maximum number of lookahead samples of a chunk (65536 by default)
+  void SetMaximumLookahead(int maximumLookahead);
+  int GetMaximumLookahead() const { return this->MaximumLookahead; }
+
+  /// Discard all samples and start a new trajectory. Parameters must be set before the first sample.
+  void Reset();
+
+  /// Add the next sample of the trajectory (acquired at timestamp, in seconds).
+  /// Returns false if the sample is not newer than the previous one, it is then ignored.
+  bool AddSample(double timestamp, const double rotation[4], const double translation[3]);
+
+  /// Indicate that all samples of the trajectory were added, so that the remaining samples can be smoothed
+  void Finish();
+
+  /// Get the next smoothed sample. Returns false if no smoothed sample is available yet
+  /// (more samples must be added or Finish must be called) or all samples were retrieved.
+  /// Samples should be retrieved as soon as they are available to keep memory bounded.
+  bool PopSample(double& timestamp, double rotation[4], double translation[3]);
+
+  /// Number of smoothed samples that can be retrieved with PopSample
+  int GetNumberOfAvailableSamples() const { return this->NumberOfSmoothedSamples - this->NumberOfPoppedSamples; }
+
+protected:
+  /// Run the backward pass over all buffered samples and make the first count ones available
+  void SmoothBufferedSamples(int count);
+  /// Remove the retrieved samples from the buffer and smooth the next chunk if it is ready
+  void UpdateBuffer();
+  /// Weight of the samples past the lookahead of the current chunk in the backward output
+  void ComputeLookaheadWeight();
+  void InitializeFilter(vtkSlicerTransformSmootherFilterBank& filter) const;
+
+  double CutOffFrequency;
+  int InterpolationMode;
+  int ChunkSize;
+  double Tolerance;
+  int MaximumLookahead;
+
+  vtkSlicerTransformSmootherFilterBank ForwardFilter;
+  vtkSlicerTransformSmootherFilterBank BackwardFilter;
+
+  // Buffered samples: timestamps, output of the forward pass, and output of the backward pass
+  // (only valid for the first NumberOfSmoothedSamples samples)
+  std::vector< double > Timestamps;
+  vtkSlicerTransformSmootherPoseArrays ForwardPoses;
+  vtkSlicerTransformSmootherPoseArrays SmoothedPoses;
+  int NumberOfSmoothedSamples;
+  int NumberOfPoppedSamples;
+  double LookaheadWeight;
+  bool Finished;
+};
+
+#endif
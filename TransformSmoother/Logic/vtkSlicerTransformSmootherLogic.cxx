@@ -18,18 +18,1022 @@
 // TransformSmoother Logic includes
 #include "vtkSlicerTransformSmootherLogic.h"
 
+// TransformSmoother Core includes
+#include "vtkSlicerTransformSmootherFilterBank.h"
+#include "vtkSlicerTransformSmootherPoseHistory.h"
+#include "vtkSlicerTransformSmootherRingBuffer.h"
+#include "vtkSlicerTransformSmootherStatistics.h"
+#include "vtkSlicerTransformSmootherTrajectoryReader.h"
+#include "vtkSlicerTransformSmootherTrajectoryWriter.h"
+#include "vtkSlicerTransformSmootherZeroPhaseSmoother.h"
+
 // MRML includes
 #include <vtkMRMLScene.h>
 
 // VTK includes
+#include <vtkAbstractTransform.h>
+#include <vtkConditionVariable.h>
+#include <vtkDoubleArray.h>
 #include <vtkIntArray.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
 
 // STD includes
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <vtkWindows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+//----------------------------------------------------------------------------
+class vtkSlicerTransformSmootherLogic::vtkInternal
+{
+public:
+  vtkInternal();
+  ~vtkInternal();
+
+  /// Add the filters of a module node, one per channel (if it has none yet), and return the index of its first filter
+  int AddFilters(vtkMRMLTransformSmootherNode* tsNode);
+  /// Remove the filters of a module node. The filters of the following module nodes are moved down,
+  /// so that the filters of each module node stay contiguous.
+  void RemoveFilters(vtkMRMLTransformSmootherNode* tsNode);
+  /// Return the index of the filter of the first channel of a module node, -1 if it has none
+  int GetFilterIndex(vtkMRMLTransformSmootherNode* tsNode) const;
+  /// Get the index of the first filter and the number of filters of a module node. Returns false if it has none.
+  bool GetFilterRange(vtkMRMLTransformSmootherNode* tsNode, int& first, int& count) const;
+  /// Update the filters of a module node from the node. The filters are recreated if its number of channels changed.
+  void UpdateFilters(vtkMRMLTransformSmootherNode* tsNode);
+  /// Update the cached parameters and transform nodes of the filter of a channel from its module node
+  void UpdateFilter(int index, int channel);
+  /// Forget a transform node that is about to be deleted
+  void RemoveTransformNode(vtkMRMLNode* transformNode);
+  /// Append an input sample of the filter at index to its trajectory file, if it is recorded
+  void RecordSample(int index, const double rotation[4], const double translation[3], double timestamp);
+  void RecordSample(int index, vtkMatrix4x4* inputMatrix, double timestamp);
+  /// Modification time of the input transform of the filter at index. The transform is modified
+  /// even if the modified events of the input node are disabled, unlike the node.
+  unsigned long GetInputTime(int index) const;
+  /// Whether the input transform of the filter at index was modified since its last sample.
+  /// If sampled is true the input is marked as sampled.
+  bool IsInputModified(int index, bool sampled);
+  /// Close the trajectory file of the filter at index. Returns false if it could not be completely written.
+  bool StopRecording(int index);
+  /// Append the filtered pose of the filter at index (after its sample at timestamp) to its pose history, if it has one
+  void AddToHistory(int index, double timestamp);
+  void AddToHistory(int index, double timestamp, const double rotation[4], const double translation[3]);
+
+  /// Background filtering: the filter bank is only accessed by the worker thread while it runs.
+  bool IsWorkerRunning() const { return this->WorkerThreadId >= 0; }
+  void StartWorker();
+  void StopWorker();
+  /// Stop the worker thread, then filter the samples it did not process yet and publish the results,
+  /// so that the calling (main) thread can access the filter bank. Returns true if the worker was running.
+  bool SuspendWorker();
+  void WakeUpWorker();
+  static VTK_THREAD_RETURN_TYPE WorkerMain(void* arg);
+  /// Queue a new input sample of the filter at index for the worker. Returns false if the queue is full.
+  bool QueueSample(int index, vtkMatrix4x4* inputMatrix, double timestamp);
+  /// Filter queued samples until the queue is empty or the filtered sample queue is full
+  void ProcessQueuedSamples();
+  /// Write the latest filtered pose of each filter to its output transform node (main thread)
+  void PublishFilteredSamples();
+  /// Write outputMatrix to the output transform node of the filter at index, unless it is within the
+  /// output deadband of the last written transform. Returns false if the write is suppressed.
+  /// If the output node is shared with other filters, the pose is only stored and the fused pose of
+  /// all these filters is written at EndOutputBatch (or right away outside of an output batch).
+  bool WriteOutput(int index, vtkMatrix4x4* outputMatrix);
+  /// Write outputMatrix to the output transform node of the filter at index, applying its output deadband
+  bool WriteOutputNode(int index, vtkMatrix4x4* outputMatrix);
+  /// Write the weighted average of the latest output poses of each group of filters sharing an output
+  /// node that got a new output pose since the previous call, once per output node
+  void WriteFusedOutputs();
+  /// Write the fused outputs left pending while DeferFusedOutputs was set, in an output batch
+  void WritePendingFusedOutputs();
+  /// Find the filters that share an output node, to be called when output nodes change
+  void UpdateFusions();
+  /// Output transform nodes written between BeginOutputBatch and EndOutputBatch invoke their modified
+  /// events at EndOutputBatch only, once all outputs of the filtering tick are written
+  void BeginOutputBatch();
+  void EndOutputBatch();
+  /// Output transform of the activated filter at index after its new sample, at the output rate
+  /// of the filter. Returns false if no output is due for this sample.
+  bool GetResampledOutputMatrix(int index, vtkMatrix4x4* outputMatrix);
+
+  // Filters of a module node: one per channel, starting at First
+  struct FilterRange
+  {
+    int First;
+    int Count;
+  };
+  typedef std::map< vtkMRMLTransformSmootherNode*, FilterRange > FilterRangeMapType;
+  FilterRangeMapType FilterRanges;
+
+  // Module nodes of the scene and the transform nodes of their channels, in the order of the filters
+  std::vector< vtkMRMLTransformSmootherNode* > Nodes;
+  std::vector< vtkMRMLLinearTransformNode* > InputNodes;
+  std::vector< vtkMRMLLinearTransformNode* > OutputNodes;
+
+  // Statistics of the module nodes that collect them, NULL for the others
+  std::vector< vtkSlicerTransformSmootherStatistics* > Statistics;
+
+  // Trajectory files of the module nodes that are recorded, NULL for the others
+  std::vector< vtkSlicerTransformSmootherTrajectoryWriter* > Recorders;
+
+  // Latest filtered poses of the module nodes that keep a pose history, NULL for the others.
+  // Only accessed on the main thread.
+  std::vector< vtkSlicerTransformSmootherPoseHistory* > Histories;
+
+  // Output deadbands of the module nodes: squared translation deadband (in mm^2) and cosine of
+  // half the rotation deadband, the last written output pose and the number of suppressed writes
+  std::vector< double > TranslationDeadbands2;
+  std::vector< double > RotationDeadbandCosines;
+  vtkSlicerTransformSmootherPoseArrays WrittenPoses;
+  std::vector< unsigned char > WrittenOutputs;
+  std::vector< vtkIdType > SuppressedWrites;
+
+  // Output transform nodes written in the current output batch and their modify state before the batch
+  struct BatchedOutput
+  {
+    vtkSmartPointer< vtkMRMLLinearTransformNode > Node;
+    int PreviousDisableModify;
+  };
+  std::vector< BatchedOutput > BatchedOutputs;
+  bool OutputBatch;
+  // Fused outputs are only written by WritePendingFusedOutputs while set (filtering of single channels)
+  bool DeferFusedOutputs;
+
+  // Filters sharing an output node: the members of a fusion are FusionMembers[First, First + Count),
+  // the fused pose is written through the first member. FusionIndices is the fusion of each filter,
+  // -1 if its output node is not shared. FusedPoses are the latest output poses of the filters and
+  // FusedPoseWeights their weights, 0 until a filter has an output pose.
+  struct Fusion
+  {
+    int First;
+    int Count;
+    bool Pending;
+  };
+  std::vector< Fusion > Fusions;
+  std::vector< int > FusionMembers;
+  std::vector< int > FusionIndices;
+  std::vector< int > PendingFusions;
+  std::vector< double > FusionWeights;
+  vtkSlicerTransformSmootherPoseArrays FusedPoses;
+  std::vector< double > FusedPoseWeights;
+  vtkNew<vtkMatrix4x4> FusedMatrix;
+
+  // Filter states of all module nodes
+  vtkSlicerTransformSmootherFilterBank Filters;
+
+  // Input samples gathered by FilterAll and whether the filter could get one
+  vtkSlicerTransformSmootherPoseArrays InputPoses;
+  std::vector< unsigned char > ValidInputs;
+  // Modification time of the input transform of each filter at its last sample, 0 if none
+  std::vector< unsigned long > InputTimes;
+
+  // Preallocated matrices used by Filter
+  vtkNew<vtkMatrix4x4> InputMatrix;
+  vtkNew<vtkMatrix4x4> OutputMatrix;
+
+  // Preallocated matrices used by GetTransformAtTime
+  vtkNew<vtkMatrix4x4> HistoryMatrixBefore;
+  vtkNew<vtkMatrix4x4> HistoryMatrixAfter;
+
+  // Input samples and filter parameter changes, from the main thread to the worker thread
+  struct QueuedSample
+  {
+    enum
+      {
+      Sample,
+      Parameters
+      };
+    int Type;
+    int Index;
+    double Timestamp;
+    double Rotation[4];
+    double Translation[3];
+    bool Timed;
+    vtkSlicerTransformSmootherFilterBank::FilterParameters FilterParameters;
+  };
+  vtkSlicerTransformSmootherRingBuffer< QueuedSample > QueuedSamples;
+
+  // Filtered poses (or dropped samples), from the worker thread to the main thread
+  struct FilteredSample
+  {
+    int Index;
+    double Timestamp;
+    double Rotation[4]; // filtered pose at Timestamp
+    double Translation[3];
+    double OutputRotation[4]; // output pose, at the output rate of the filter
+    double OutputTranslation[3];
+    bool Dropped;
+    bool HasOutput; // false if no output is due at the output rate of the filter
+    double FilterTime;
+  };
+  vtkSlicerTransformSmootherRingBuffer< FilteredSample > FilteredSamples;
+
+  // Latest filtered pose of each filter that is not written to the scene yet
+  vtkSlicerTransformSmootherPoseArrays PendingPoses;
+  std::vector< unsigned char > PendingOutputs;
+
+  // Worker thread, waiting on WorkerCondition when there is nothing to filter
+  vtkNew<vtkMultiThreader> Threader;
+  int WorkerThreadId;
+  vtkSimpleMutexLock WorkerLock;
+  vtkNew<vtkConditionVariable> WorkerCondition;
+  bool WorkerWakeUp; // protected by WorkerLock
+  bool WorkerStop; // protected by WorkerLock
+};
+
+//----------------------------------------------------------------------------
+// Queues are sized for a few updates of hundreds of module nodes
+vtkSlicerTransformSmootherLogic::vtkInternal::vtkInternal()
+  : QueuedSamples( 4096 )
+  , FilteredSamples( 4096 )
+{
+  this->OutputBatch = false;
+  this->DeferFusedOutputs = false;
+  this->WorkerThreadId = -1;
+  this->WorkerWakeUp = false;
+  this->WorkerStop = false;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTransformSmootherLogic::vtkInternal::~vtkInternal()
+{
+  // Queued samples are discarded, the transform nodes may already be deleted
+  this->StopWorker();
+  for (size_t i = 0; i < this->Recorders.size(); ++i)
+    {
+    this->StopRecording( static_cast<int>( i ) );
+    }
+  for (size_t i = 0; i < this->Histories.size(); ++i)
+    {
+    delete this->Histories[i];
+    }
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+template <class T>
+void EraseRange(std::vector< T >& values, int first, int count)
+{
+  values.erase( values.begin() + first, values.begin() + first + count );
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherLogic::vtkInternal::AddFilters(vtkMRMLTransformSmootherNode* tsNode)
+{
+  int first = this->GetFilterIndex( tsNode );
+  if ( first >= 0 )
+    {
+    return first;
+    }
+
+  const bool resumeWorker = this->SuspendWorker();
+  const int count = std::max( 1, tsNode->GetNumberOfChannels() );
+  first = this->Filters.GetNumberOfFilters();
+  for (int channel = 0; channel < count; ++channel)
+    {
+    this->Filters.AddFilter();
+    this->Nodes.push_back( tsNode );
+    this->InputNodes.push_back( NULL );
+    this->OutputNodes.push_back( NULL );
+    this->Statistics.push_back( NULL );
+    this->Recorders.push_back( NULL );
+    this->Histories.push_back( NULL );
+    this->TranslationDeadbands2.push_back( 0.0 );
+    this->RotationDeadbandCosines.push_back( 1.0 );
+    this->WrittenOutputs.push_back( 0 );
+    this->SuppressedWrites.push_back( 0 );
+    this->FusionWeights.push_back( 1.0 );
+    this->FusedPoseWeights.push_back( 0.0 );
+    this->PendingOutputs.push_back( 0 );
+    this->ValidInputs.push_back( 0 );
+    this->InputTimes.push_back( 0 );
+    }
+  const int numberOfFilters = static_cast<int>( this->Nodes.size() );
+  this->WrittenPoses.Resize( numberOfFilters );
+  this->FusedPoses.Resize( numberOfFilters );
+  this->PendingPoses.Resize( numberOfFilters );
+  this->InputPoses.Resize( numberOfFilters );
+  this->BatchedOutputs.reserve( this->Nodes.size() );
+  FilterRange range;
+  range.First = first;
+  range.Count = count;
+  this->FilterRanges[tsNode] = range;
+  this->UpdateFilters( tsNode );
+  if ( resumeWorker )
+    {
+    this->StartWorker();
+    }
+  return first;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::RemoveFilters(vtkMRMLTransformSmootherNode* tsNode)
+{
+  int first = 0;
+  int count = 0;
+  if ( !this->GetFilterRange( tsNode, first, count ) )
+    {
+    return;
+    }
+
+  // Queued samples refer to filter indices, which change
+  const bool resumeWorker = this->SuspendWorker();
+
+  for (int index = first; index < first + count; ++index)
+    {
+    this->StopRecording( index );
+    delete this->Histories[index];
+    }
+  this->FilterRanges.erase( tsNode );
+  for (FilterRangeMapType::iterator it = this->FilterRanges.begin(); it != this->FilterRanges.end(); ++it)
+    {
+    if ( it->second.First > first )
+      {
+      it->second.First -= count;
+      }
+    }
+
+  this->Filters.RemoveFilters( first, count );
+  EraseRange( this->Nodes, first, count );
+  EraseRange( this->InputNodes, first, count );
+  EraseRange( this->OutputNodes, first, count );
+  EraseRange( this->Statistics, first, count );
+  EraseRange( this->Recorders, first, count );
+  EraseRange( this->Histories, first, count );
+  EraseRange( this->TranslationDeadbands2, first, count );
+  EraseRange( this->RotationDeadbandCosines, first, count );
+  this->WrittenPoses.Erase( first, count );
+  EraseRange( this->WrittenOutputs, first, count );
+  EraseRange( this->SuppressedWrites, first, count );
+  EraseRange( this->FusionWeights, first, count );
+  this->FusedPoses.Erase( first, count );
+  EraseRange( this->FusedPoseWeights, first, count );
+  this->PendingPoses.Erase( first, count );
+  EraseRange( this->PendingOutputs, first, count );
+  this->InputPoses.Erase( first, count );
+  EraseRange( this->ValidInputs, first, count );
+  EraseRange( this->InputTimes, first, count );
+  this->UpdateFusions();
+
+  if ( resumeWorker )
+    {
+    this->StartWorker();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherLogic::vtkInternal::GetFilterIndex(vtkMRMLTransformSmootherNode* tsNode) const
+{
+  FilterRangeMapType::const_iterator it = this->FilterRanges.find( tsNode );
+  return ( it != this->FilterRanges.end() ) ? it->second.First : -1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::GetFilterRange(vtkMRMLTransformSmootherNode* tsNode,
+  int& first, int& count) const
+{
+  FilterRangeMapType::const_iterator it = this->FilterRanges.find( tsNode );
+  if ( it == this->FilterRanges.end() )
+    {
+    return false;
+    }
+  first = it->second.First;
+  count = it->second.Count;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::UpdateFilters(vtkMRMLTransformSmootherNode* tsNode)
+{
+  int first = 0;
+  int count = 0;
+  if ( !this->GetFilterRange( tsNode, first, count ) )
+    {
+    return;
+    }
+
+  if ( count != std::max( 1, tsNode->GetNumberOfChannels() ) )
+    {
+    // Channels added or removed: the filters of the node restart, its trajectory file is kept
+    vtkSlicerTransformSmootherTrajectoryWriter* recorder = this->Recorders[first];
+    this->Recorders[first] = NULL;
+    this->RemoveFilters( tsNode );
+    this->Recorders[ this->AddFilters( tsNode ) ] = recorder;
+    return;
+    }
+
+  for (int channel = 0; channel < count; ++channel)
+    {
+    this->UpdateFilter( first + channel, channel );
+    }
+  this->UpdateFusions();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::UpdateFilter(int index, int channel)
+{
+  vtkMRMLTransformSmootherNode* tsNode = this->Nodes[index];
+  if ( this->InputNodes[index] != tsNode->GetNthInputTransformNode( channel ) )
+    {
+    // The current transform of a new input node is a new sample
+    this->InputTimes[index] = 0;
+    }
+  this->InputNodes[index] = tsNode->GetNthInputTransformNode( channel );
+  if ( this->OutputNodes[index] != tsNode->GetNthFilteredTransformNode( channel ) )
+    {
+    // The deadband applies to the transform written to this output node
+    this->WrittenOutputs[index] = 0;
+    this->FusedPoseWeights[index] = 0.0;
+    }
+  this->OutputNodes[index] = tsNode->GetNthFilteredTransformNode( channel );
+  this->Statistics[index] = tsNode->GetStatisticsEnabled() ? &tsNode->GetStatistics() : NULL;
+
+  const double translationDeadband = tsNode->GetOutputTranslationDeadband();
+  this->TranslationDeadbands2[index] = translationDeadband * translationDeadband;
+  this->RotationDeadbandCosines[index] = cos( vtkMath::RadiansFromDegrees( tsNode->GetOutputRotationDeadband() ) / 2.0 );
+  this->FusionWeights[index] = tsNode->GetFusionWeight();
+
+  // Pose history storage is only allocated when its length changes
+  const int historyLength = tsNode->GetPoseHistoryLength();
+  if ( historyLength <= 0 )
+    {
+    delete this->Histories[index];
+    this->Histories[index] = NULL;
+    }
+  else
+    {
+    if ( this->Histories[index] == NULL )
+      {
+      this->Histories[index] = new vtkSlicerTransformSmootherPoseHistory;
+      }
+    this->Histories[index]->SetCapacity( historyLength );
+    }
+
+  vtkSlicerTransformSmootherFilterBank::FilterParameters parameters;
+  parameters.Activated = tsNode->GetFilterActivated();
+  parameters.FilterMode = tsNode->GetFilterMode();
+  parameters.FilterOrder = tsNode->GetFilterOrder();
+  parameters.CutOffFrequency = tsNode->GetCutOffFrequency();
+  parameters.MinCutOffFrequency = tsNode->GetMinCutOffFrequency();
+  parameters.Beta = tsNode->GetBeta();
+  parameters.PredictionTime = tsNode->GetPredictionTime();
+  parameters.ProcessNoise = tsNode->GetProcessNoise();
+  parameters.MeasurementNoise = tsNode->GetMeasurementNoise();
+  parameters.InterpolationMode = tsNode->GetInterpolationMode();
+  parameters.OutputRate = tsNode->GetOutputRate();
+
+  if ( !this->IsWorkerRunning() )
+    {
+    this->Filters.SetFilterParameters( index, parameters );
+    return;
+    }
+
+  // Parameters are applied by the worker between the samples queued before and after the change
+  QueuedSample* queuedSample = this->QueuedSamples.BeginPush();
+  if ( queuedSample == NULL )
+    {
+    // Parameter changes must not be lost, apply it once the worker has processed the queue
+    this->SuspendWorker();
+    this->Filters.SetFilterParameters( index, parameters );
+    this->StartWorker();
+    return;
+    }
+  queuedSample->Type = QueuedSample::Parameters;
+  queuedSample->Index = index;
+  queuedSample->FilterParameters = parameters;
+  this->QueuedSamples.EndPush();
+  this->WakeUpWorker();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::RemoveTransformNode(vtkMRMLNode* transformNode)
+{
+  for (size_t i = 0; i < this->Nodes.size(); ++i)
+    {
+    if ( this->InputNodes[i] == transformNode )
+      {
+      this->InputNodes[i] = NULL;
+      }
+    if ( this->OutputNodes[i] == transformNode )
+      {
+      this->OutputNodes[i] = NULL;
+      this->FusedPoseWeights[i] = 0.0;
+      }
+    }
+  this->UpdateFusions();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::RecordSample(int index,
+  const double rotation[4], const double translation[3], double timestamp)
+{
+  vtkSlicerTransformSmootherTrajectoryWriter* recorder = this->Recorders[index];
+  if ( recorder != NULL )
+    {
+    recorder->WriteSample( timestamp, rotation, translation );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::RecordSample(int index, vtkMatrix4x4* inputMatrix, double timestamp)
+{
+  if ( this->Recorders[index] == NULL )
+    {
+    return;
+    }
+  double rotation[4];
+  double translation[3];
+  vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( inputMatrix->Element, rotation, translation );
+  this->RecordSample( index, rotation, translation, timestamp );
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkSlicerTransformSmootherLogic::vtkInternal::GetInputTime(int index) const
+{
+  vtkAbstractTransform* transform = this->InputNodes[index]->GetTransformToParent();
+  return ( transform != NULL ) ? transform->GetMTime() : 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::IsInputModified(int index, bool sampled)
+{
+  const unsigned long inputTime = this->GetInputTime( index );
+  const bool modified = ( inputTime != this->InputTimes[index] || inputTime == 0 );
+  if ( sampled )
+    {
+    this->InputTimes[index] = inputTime;
+    }
+  return modified;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::StopRecording(int index)
+{
+  vtkSlicerTransformSmootherTrajectoryWriter* recorder = this->Recorders[index];
+  if ( recorder == NULL )
+    {
+    return false;
+    }
+  const bool success = recorder->Close();
+  delete recorder;
+  this->Recorders[index] = NULL;
+  return success;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::AddToHistory(int index, double timestamp)
+{
+  if ( this->Histories[index] == NULL )
+    {
+    return;
+    }
+  double rotation[4];
+  double translation[3];
+  this->Filters.GetOutputPose( index, rotation, translation );
+  this->Histories[index]->AddPose( timestamp, rotation, translation );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::AddToHistory(int index, double timestamp,
+  const double rotation[4], const double translation[3])
+{
+  if ( this->Histories[index] != NULL )
+    {
+    this->Histories[index]->AddPose( timestamp, rotation, translation );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::StartWorker()
+{
+  if ( this->IsWorkerRunning() )
+    {
+    return;
+    }
+  this->WorkerWakeUp = false;
+  this->WorkerStop = false;
+  this->WorkerThreadId = this->Threader->SpawnThread(
+    &vtkSlicerTransformSmootherLogic::vtkInternal::WorkerMain, this );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::StopWorker()
+{
+  if ( !this->IsWorkerRunning() )
+    {
+    return;
+    }
+  this->WorkerLock.Lock();
+  this->WorkerStop = true;
+  this->WorkerCondition->Signal();
+  this->WorkerLock.Unlock();
+  this->Threader->TerminateThread( this->WorkerThreadId );
+  this->WorkerThreadId = -1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::SuspendWorker()
+{
+  if ( !this->IsWorkerRunning() )
+    {
+    return false;
+    }
+  this->StopWorker();
+
+  // Finish the work of the worker on this thread
+  while ( !this->QueuedSamples.IsEmpty() )
+    {
+    this->ProcessQueuedSamples();
+    this->PublishFilteredSamples();
+    }
+  this->PublishFilteredSamples();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::WakeUpWorker()
+{
+  this->WorkerLock.Lock();
+  this->WorkerWakeUp = true;
+  this->WorkerCondition->Signal();
+  this->WorkerLock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSlicerTransformSmootherLogic::vtkInternal::WorkerMain(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast< vtkMultiThreader::ThreadInfo* >( arg );
+  vtkInternal* self = static_cast< vtkInternal* >( threadInfo->UserData );
+  for (;;)
+    {
+    self->ProcessQueuedSamples();
+
+    // Wait for new samples or for room in the filtered sample queue.
+    // The lock is never held while filtering, so the main thread is not blocked by the worker.
+    self->WorkerLock.Lock();
+    while ( !self->WorkerWakeUp && !self->WorkerStop )
+      {
+      self->WorkerCondition->Wait( self->WorkerLock );
+      }
+    const bool stop = self->WorkerStop;
+    self->WorkerWakeUp = false;
+    self->WorkerLock.Unlock();
+    if ( stop )
+      {
+      break;
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::QueueSample(int index, vtkMatrix4x4* inputMatrix, double timestamp)
+{
+  QueuedSample* queuedSample = this->QueuedSamples.BeginPush();
+  if ( queuedSample == NULL )
+    {
+    return false;
+    }
+  queuedSample->Type = QueuedSample::Sample;
+  queuedSample->Index = index;
+  queuedSample->Timestamp = timestamp;
+  queuedSample->Timed = ( this->Statistics[index] != NULL );
+  vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( inputMatrix->Element,
+    queuedSample->Rotation, queuedSample->Translation );
+  this->QueuedSamples.EndPush();
+  this->WakeUpWorker();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::ProcessQueuedSamples()
+{
+  const QueuedSample* queuedSample = NULL;
+  while ( ( queuedSample = this->QueuedSamples.Front() ) != NULL )
+    {
+    if ( queuedSample->Type == QueuedSample::Parameters )
+      {
+      this->Filters.SetFilterParameters( queuedSample->Index, queuedSample->FilterParameters );
+      this->QueuedSamples.Pop();
+      continue;
+      }
+
+    FilteredSample* filteredSample = this->FilteredSamples.BeginPush();
+    if ( filteredSample == NULL )
+      {
+      // Wait until the main thread publishes the filtered samples
+      return;
+      }
+
+    const int index = queuedSample->Index;
+    const double startTime = queuedSample->Timed ? vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() : 0.0;
+    filteredSample->Index = index;
+    filteredSample->Timestamp = queuedSample->Timestamp;
+    filteredSample->Dropped = !this->Filters.SetSample( index, queuedSample->Timestamp,
+      queuedSample->Rotation, queuedSample->Translation );
+    filteredSample->HasOutput = false;
+    if ( !filteredSample->Dropped )
+      {
+      double outputTimestamp = 0.0;
+      this->Filters.GetOutputPose( index, filteredSample->Rotation, filteredSample->Translation );
+      filteredSample->HasOutput = this->Filters.GetResampledOutputPose( index, outputTimestamp,
+        filteredSample->OutputRotation, filteredSample->OutputTranslation );
+      }
+    filteredSample->FilterTime = queuedSample->Timed ?
+      vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - startTime : 0.0;
+
+    this->FilteredSamples.EndPush();
+    this->QueuedSamples.Pop();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::PublishFilteredSamples()
+{
+  // Keep the latest filtered pose of each filter
+  bool published = false;
+  double outputTime = -1.0;
+  const FilteredSample* filteredSample = NULL;
+  while ( ( filteredSample = this->FilteredSamples.Front() ) != NULL )
+    {
+    const int index = filteredSample->Index;
+    vtkSlicerTransformSmootherStatistics* statistics = this->Statistics[index];
+    if ( filteredSample->Dropped )
+      {
+      if ( statistics != NULL )
+        {
+        statistics->AddDroppedSample();
+        }
+      }
+    else
+      {
+      this->AddToHistory( index, filteredSample->Timestamp, filteredSample->Rotation, filteredSample->Translation );
+      if ( filteredSample->HasOutput )
+        {
+        this->PendingPoses.SetPose( index, filteredSample->OutputRotation, filteredSample->OutputTranslation );
+        this->PendingOutputs[index] = 1;
+        }
+      if ( statistics != NULL )
+        {
+        outputTime = ( outputTime < 0.0 ) ? vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() : outputTime;
+        statistics->AddProcessedSample( filteredSample->FilterTime, outputTime - filteredSample->Timestamp );
+        }
+      }
+    this->FilteredSamples.Pop();
+    published = true;
+    }
+  if ( !published )
+    {
+    return;
+    }
+
+  // The worker may be waiting for room in the filtered sample queue
+  if ( this->IsWorkerRunning() )
+    {
+    this->WakeUpWorker();
+    }
+
+  vtkMatrix4x4* matrixOutput = this->OutputMatrix.GetPointer();
+  const int numberOfFilters = static_cast<int>( this->Nodes.size() );
+  this->BeginOutputBatch();
+  for (int i = 0; i < numberOfFilters; ++i)
+    {
+    if ( !this->PendingOutputs[i] )
+      {
+      continue;
+      }
+    this->PendingOutputs[i] = 0;
+    if ( this->OutputNodes[i] == NULL || this->OutputNodes[i] == this->InputNodes[i] )
+      {
+      continue;
+      }
+    double rotation[4];
+    double translation[3];
+    this->PendingPoses.GetPose( i, rotation, translation );
+    vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, matrixOutput->Element );
+    matrixOutput->Modified();
+    this->WriteOutput( i, matrixOutput );
+    }
+  this->EndOutputBatch();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::WriteOutput(int index, vtkMatrix4x4* outputMatrix)
+{
+  const int fusionIndex = this->FusionIndices[index];
+  if ( fusionIndex < 0 )
+    {
+    return this->WriteOutputNode( index, outputMatrix );
+    }
+
+  double rotation[4];
+  double translation[3];
+  vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( outputMatrix->Element, rotation, translation );
+  this->FusedPoses.SetPose( index, rotation, translation );
+  this->FusedPoseWeights[index] = this->FusionWeights[index];
+  Fusion& fusion = this->Fusions[fusionIndex];
+  if ( !fusion.Pending )
+    {
+    fusion.Pending = true;
+    this->PendingFusions.push_back( fusionIndex );
+    }
+  if ( !this->OutputBatch && !this->DeferFusedOutputs )
+    {
+    this->WriteFusedOutputs();
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::WriteOutputNode(int index, vtkMatrix4x4* outputMatrix)
+{
+  const double translationDeadband2 = this->TranslationDeadbands2[index];
+  const double rotationDeadbandCosine = this->RotationDeadbandCosines[index];
+  if ( translationDeadband2 > 0.0 || rotationDeadbandCosine < 1.0 )
+    {
+    double rotation[4];
+    double translation[3];
+    vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( outputMatrix->Element, rotation, translation );
+    if ( this->WrittenOutputs[index] )
+      {
+      double writtenRotation[4];
+      double writtenTranslation[3];
+      this->WrittenPoses.GetPose( index, writtenRotation, writtenTranslation );
+      // The cosine of half the rotation angle between two unit quaternions is their dot product, up to the sign
+      const double rotationCosine = fabs( rotation[0] * writtenRotation[0] + rotation[1] * writtenRotation[1]
+        + rotation[2] * writtenRotation[2] + rotation[3] * writtenRotation[3] );
+      if ( vtkMath::Distance2BetweenPoints( translation, writtenTranslation ) <= translationDeadband2
+        && rotationCosine >= rotationDeadbandCosine )
+        {
+        ++this->SuppressedWrites[index];
+        return false;
+        }
+      }
+    this->WrittenPoses.SetPose( index, rotation, translation );
+    this->WrittenOutputs[index] = 1;
+    }
+  if ( this->OutputBatch )
+    {
+    BatchedOutput batchedOutput;
+    batchedOutput.Node = this->OutputNodes[index];
+    batchedOutput.PreviousDisableModify = this->OutputNodes[index]->StartModify();
+    this->BatchedOutputs.push_back( batchedOutput );
+    }
+  this->OutputNodes[index]->SetMatrixTransformToParent( outputMatrix );
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::WriteFusedOutputs()
+{
+  vtkMatrix4x4* fusedMatrix = this->FusedMatrix.GetPointer();
+  for (size_t i = 0; i < this->PendingFusions.size(); ++i)
+    {
+    Fusion& fusion = this->Fusions[ this->PendingFusions[i] ];
+    fusion.Pending = false;
+    double rotation[4];
+    double translation[3];
+    if ( !vtkSlicerTransformSmootherFilterBank::GetAveragePose( this->FusedPoses, &this->FusionMembers[fusion.First],
+      fusion.Count, &this->FusedPoseWeights[0], rotation, translation ) )
+      {
+      // Only filters with a zero weight have an output pose
+      continue;
+      }
+    vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, fusedMatrix->Element );
+    fusedMatrix->Modified();
+    this->WriteOutputNode( this->FusionMembers[fusion.First], fusedMatrix );
+    }
+  this->PendingFusions.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::WritePendingFusedOutputs()
+{
+  if ( this->DeferFusedOutputs || this->PendingFusions.empty() )
+    {
+    return;
+    }
+  this->BeginOutputBatch();
+  this->EndOutputBatch();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::UpdateFusions()
+{
+  // Filters of each shared output node, in filter order
+  typedef std::map< vtkMRMLLinearTransformNode*, std::vector< int > > OutputFilterMapType;
+  OutputFilterMapType outputFilters;
+  const int numberOfFilters = static_cast<int>( this->OutputNodes.size() );
+  for (int i = 0; i < numberOfFilters; ++i)
+    {
+    if ( this->OutputNodes[i] != NULL && this->OutputNodes[i] != this->InputNodes[i] )
+      {
+      outputFilters[ this->OutputNodes[i] ].push_back( i );
+      }
+    }
+
+  this->Fusions.clear();
+  this->FusionMembers.clear();
+  this->PendingFusions.clear();
+  this->FusionIndices.assign( numberOfFilters, -1 );
+  for (OutputFilterMapType::iterator it = outputFilters.begin(); it != outputFilters.end(); ++it)
+    {
+    const std::vector< int >& filters = it->second;
+    if ( filters.size() < 2 )
+      {
+      continue;
+      }
+    Fusion fusion;
+    fusion.First = static_cast<int>( this->FusionMembers.size() );
+    fusion.Count = static_cast<int>( filters.size() );
+    fusion.Pending = false;
+    for (size_t i = 0; i < filters.size(); ++i)
+      {
+      this->FusionIndices[ filters[i] ] = static_cast<int>( this->Fusions.size() );
+      this->FusionMembers.push_back( filters[i] );
+      }
+    // The fused pose is written through the first member, the deadband applies to the fused pose
+    this->WrittenOutputs[ filters[0] ] = 0;
+    this->Fusions.push_back( fusion );
+    }
+  for (int i = 0; i < numberOfFilters; ++i)
+    {
+    if ( this->FusionIndices[i] < 0 )
+      {
+      // Output poses are only kept while the output node is shared
+      this->FusedPoseWeights[i] = 0.0;
+      }
+    }
+  this->PendingFusions.reserve( this->Fusions.size() );
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::BeginOutputBatch()
+{
+  this->OutputBatch = true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::vtkInternal::EndOutputBatch()
+{
+  // Fused outputs are written in the batch, unless they are deferred to WritePendingFusedOutputs
+  if ( !this->DeferFusedOutputs )
+    {
+    this->WriteFusedOutputs();
+    }
+  this->OutputBatch = false;
+
+  // EndModify invokes the modified events right away. Observers may filter again (e.g. a module node
+  // whose input is this filtered transform) and run their own output batch, so the batched outputs
+  // are moved out of BatchedOutputs first. Swapping vectors does not allocate.
+  std::vector< BatchedOutput > batchedOutputs;
+  batchedOutputs.swap( this->BatchedOutputs );
+  // In reverse order, so that a node written several times gets its modify state back last
+  for (std::vector< BatchedOutput >::reverse_iterator it = batchedOutputs.rbegin();
+    it != batchedOutputs.rend(); ++it)
+    {
+    it->Node->EndModify( it->PreviousDisableModify );
+    }
+  batchedOutputs.clear();
+  if ( this->BatchedOutputs.empty() )
+    {
+    // Keep the reserved storage for the next batch
+    batchedOutputs.swap( this->BatchedOutputs );
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::vtkInternal::GetResampledOutputMatrix(int index, vtkMatrix4x4* outputMatrix)
+{
+  double outputTimestamp = 0.0;
+  double rotation[4];
+  double translation[3];
+  if ( !this->Filters.GetResampledOutputPose( index, outputTimestamp, rotation, translation ) )
+    {
+    return false;
+    }
+  vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, outputMatrix->Element );
+  outputMatrix->Modified();
+  return true;
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerTransformSmootherLogic);
@@ -37,17 +1041,22 @@ vtkStandardNewMacro(vtkSlicerTransformSmootherLogic);
 //----------------------------------------------------------------------------
 vtkSlicerTransformSmootherLogic::vtkSlicerTransformSmootherLogic()
 {
+  this->Internal = new vtkInternal;
+  this->BackgroundFiltering = false;
 }
 
 //----------------------------------------------------------------------------
 vtkSlicerTransformSmootherLogic::~vtkSlicerTransformSmootherLogic()
 {
+  delete this->Internal;
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerTransformSmootherLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "BackgroundFiltering: " << this->BackgroundFiltering << std::endl;
 }
 
 //---------------------------------------------------------------------------
@@ -72,6 +1081,37 @@ void vtkSlicerTransformSmootherLogic::RegisterNodes()
 void vtkSlicerTransformSmootherLogic::UpdateFromMRMLScene()
 {
   assert(this->GetMRMLScene() != 0);
+
+  // Synchronize filters with the module nodes of the scene, keeping the state of existing filters
+  std::vector< vtkMRMLNode* > nodes;
+  this->GetMRMLScene()->GetNodesByClass( "vtkMRMLTransformSmootherNode", nodes );
+
+  std::vector< vtkMRMLTransformSmootherNode* > removedNodes = this->Internal->Nodes;
+  for (std::vector< vtkMRMLNode* >::iterator it = nodes.begin(); it != nodes.end(); ++it)
+    {
+    vtkMRMLTransformSmootherNode* tsNode = vtkMRMLTransformSmootherNode::SafeDownCast( *it );
+    removedNodes.erase( std::remove( removedNodes.begin(), removedNodes.end(), tsNode ), removedNodes.end() );
+    if ( this->Internal->GetFilterIndex( tsNode ) < 0 )
+      {
+      this->OnMRMLSceneNodeAdded( tsNode );
+      }
+    else
+      {
+      // Node references may have been updated during the batch processing
+      this->Internal->UpdateFilters( tsNode );
+      }
+    }
+
+  for (std::vector< vtkMRMLTransformSmootherNode* >::iterator it = removedNodes.begin(); it != removedNodes.end(); ++it)
+    {
+    this->Internal->RemoveFilters( *it );
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::OnMRMLSceneEndBatchProcess()
+{
+  this->UpdateFromMRMLScene();
 }
 
 //---------------------------------------------------------------------------
@@ -90,7 +1130,12 @@ void vtkSlicerTransformSmootherLogic
     vtkUnObserveMRMLNodeMacro( node );
     vtkNew<vtkIntArray> events;
     events->InsertNextValue( vtkCommand::ModifiedEvent );
+    events->InsertNextValue( vtkMRMLTransformSmootherNode::InputDataModifiedEvent );
+    events->InsertNextValue( vtkMRMLNode::ReferenceAddedEvent );
+    events->InsertNextValue( vtkMRMLNode::ReferenceModifiedEvent );
+    events->InsertNextValue( vtkMRMLNode::ReferenceRemovedEvent );
     vtkObserveMRMLNodeEventsMacro( node, events.GetPointer() );
+    this->Internal->AddFilters( vtkMRMLTransformSmootherNode::SafeDownCast( node ) );
     }
 }
 
@@ -108,12 +1153,17 @@ void vtkSlicerTransformSmootherLogic
     {
     vtkDebugMacro( "OnMRMLSceneNodeRemoved" );
     vtkUnObserveMRMLNodeMacro( node );
+    this->Internal->RemoveFilters( vtkMRMLTransformSmootherNode::SafeDownCast( node ) );
+    }
+  else if ( node->IsA( "vtkMRMLLinearTransformNode" ) )
+    {
+    this->Internal->RemoveTransformNode( node );
     }
 }
 
 //---------------------------------------------------------------------------
 void vtkSlicerTransformSmootherLogic
-::ProcessMRMLNodesEvents( vtkObject* caller, unsigned long /*event*/, void* /*callData*/)
+::ProcessMRMLNodesEvents( vtkObject* caller, unsigned long event, void* callData)
 {
   vtkMRMLNode* callerNode =
     vtkMRMLNode::SafeDownCast( caller );
@@ -130,6 +1180,27 @@ void vtkSlicerTransformSmootherLogic
     }
 
   // Check for vtkMRMLTransformSmootherNode specific events
+  if ( event == vtkMRMLTransformSmootherNode::InputDataModifiedEvent )
+    {
+    // New input sample available, filter it right away
+    int* channel = reinterpret_cast< int* >( callData );
+    if ( channel != NULL )
+      {
+      this->FilterChannel( tsNode, *channel, GetCurrentTimestamp() );
+      }
+    else
+      {
+      this->Filter( tsNode );
+      }
+    }
+  else if ( event == vtkCommand::ModifiedEvent
+            || event == vtkMRMLNode::ReferenceAddedEvent
+            || event == vtkMRMLNode::ReferenceModifiedEvent
+            || event == vtkMRMLNode::ReferenceRemovedEvent )
+    {
+    // Filter parameters, transform nodes or channels changed
+    this->Internal->UpdateFilters( tsNode );
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -239,48 +1310,526 @@ void vtkSlicerTransformSmootherLogic
   }
 }
 
+//-----------------------------------------------------------------------------
+double vtkSlicerTransformSmootherLogic::GetCurrentTimestamp()
+{
+#if defined(_WIN32)
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency( &frequency );
+  QueryPerformanceCounter( &counter );
+  return static_cast<double>( counter.QuadPart ) / static_cast<double>( frequency.QuadPart );
+#elif defined(__APPLE__)
+  static mach_timebase_info_data_t timebase;
+  if ( timebase.denom == 0 )
+    {
+    mach_timebase_info( &timebase );
+    }
+  return static_cast<double>( mach_absolute_time() ) * timebase.numer / timebase.denom * 1e-9;
+#else
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return static_cast<double>( now.tv_sec ) + static_cast<double>( now.tv_nsec ) * 1e-9;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+double vtkSlicerTransformSmootherLogic::GetSmoothingFactor(double dt, double cutoffFrequency)
+{
+  return vtkSlicerTransformSmootherFilterBank::GetSmoothingFactor( dt, cutoffFrequency );
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerTransformSmootherLogic
 ::Filter(vtkMRMLTransformSmootherNode* tsNode)
 {
-  if ( tsNode == NULL )
+  this->Filter( tsNode, vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() );
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic
+::Filter(vtkMRMLTransformSmootherNode* tsNode, double timestamp)
+{
+  int first = 0;
+  int count = 0;
+  if ( !this->Internal->GetFilterRange( tsNode, first, count ) )
     {
     return;
     }
 
-  vtkMRMLLinearTransformNode* inputNode = tsNode->GetInputTransformNode();
-  vtkMRMLLinearTransformNode* outputNode = tsNode->GetFilteredTransformNode();
+  for (int i = first; i < first + count; ++i)
+    {
+    if ( this->Internal->InputNodes[i] != NULL && this->Internal->InputNodes[i] == this->Internal->OutputNodes[i] )
+      {
+      vtkWarningMacro( "Filter: Input and output transforms are the same node, filtering of channel " << i - first << " skipped" );
+      }
+    }
+
+  this->FilterRange( first, count, timestamp );
+}
 
-  if ( inputNode == NULL || outputNode == NULL )
+//-----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic
+::FilterChannel(vtkMRMLTransformSmootherNode* tsNode, int channel, double timestamp)
+{
+  int first = 0;
+  int count = 0;
+  vtkInternal* internal = this->Internal;
+  if ( !internal->GetFilterRange( tsNode, first, count ) || channel < 0 || channel >= count )
     {
     return;
     }
 
-  // Compute weights (low-pass filter with w_cutoff frequency)
-  const double dt = 0.015; // 15ms TODO: get it from timestamp
-  const double cutoff_frequency = tsNode->GetCutOffFrequency();
-  const double weightPrevious = 1;
-  const double weightCurrent = dt*cutoff_frequency;
+  // A fused output is written once per tick by PublishFilteredTransforms, not for each of its inputs
+  const bool fusedOutputsPending = !internal->PendingFusions.empty();
+  const bool deferFusedOutputs = internal->DeferFusedOutputs;
+  internal->DeferFusedOutputs = true;
+  this->FilterRange( first + channel, 1, timestamp );
+  internal->DeferFusedOutputs = deferFusedOutputs;
+  if ( !fusedOutputsPending && !internal->PendingFusions.empty() )
+    {
+    this->InvokeEvent( vtkSlicerTransformSmootherLogic::FusedOutputsPendingEvent );
+    }
+}
 
-  // Get matrices
-  vtkSmartPointer<vtkMatrix4x4> matrixCurrent = vtkSmartPointer<vtkMatrix4x4>::New();
-  inputNode->GetMatrixTransformToParent(matrixCurrent);
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic
+::ProcessSample(vtkMRMLTransformSmootherNode* tsNode, vtkMatrix4x4* inputMatrix,
+                double timestamp, vtkMatrix4x4* outputMatrix)
+{
+  if ( inputMatrix == NULL || outputMatrix == NULL )
+    {
+    return false;
+    }
+
+  vtkInternal* internal = this->Internal;
+  const int index = internal->GetFilterIndex( tsNode );
+  if ( index < 0 )
+    {
+    vtkWarningMacro( "ProcessSample: Module node is not in the scene of the logic" );
+    return false;
+    }
+
+  if ( this->BackgroundFiltering )
+    {
+    vtkWarningMacro( "ProcessSample: Not available while background filtering is enabled" );
+    return false;
+    }
 
-  vtkSmartPointer<vtkMatrix4x4> matrixPrevious = vtkSmartPointer<vtkMatrix4x4>::New();
-  outputNode->GetMatrixTransformToParent(matrixPrevious);
+  if ( !this->SetFilterSample( index, inputMatrix, timestamp ) )
+    {
+    return false;
+    }
+  internal->AddToHistory( index, timestamp );
 
-  vtkSmartPointer<vtkMatrix4x4> matrixOutput = vtkSmartPointer<vtkMatrix4x4>::New();
-  if ( tsNode->GetFilterActivated() == false )
+  if ( !internal->Filters.GetFilterActivated( index ) )
     {
     // No filter. Output Transform = Input Transform
-    inputNode->GetMatrixTransformToParent( matrixOutput );
+    outputMatrix->DeepCopy( inputMatrix );
+    return true;
+    }
+
+  double rotation[4];
+  double translation[3];
+  internal->Filters.GetOutputPose( index, rotation, translation );
+  vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, outputMatrix->Element );
+  outputMatrix->Modified();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic
+::SetFilterSample(int index, vtkMatrix4x4* inputMatrix, double timestamp, bool smooth)
+{
+  double rotation[4];
+  double translation[3];
+  vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( inputMatrix->Element, rotation, translation );
+  return this->Internal->Filters.SetSample( index, timestamp, rotation, translation, smooth );
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::FilterAll()
+{
+  this->FilterAll( vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() );
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::FilterAll(double timestamp)
+{
+  this->FilterRange( 0, static_cast<int>( this->Internal->Nodes.size() ), timestamp, true );
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::FilterRange(int first, int count, double timestamp, bool modifiedInputsOnly)
+{
+  vtkInternal* internal = this->Internal;
+  const int end = first + count;
+  vtkMatrix4x4* matrixCurrent = internal->InputMatrix.GetPointer();
+  vtkMatrix4x4* matrixOutput = internal->OutputMatrix.GetPointer();
+
+  if ( this->BackgroundFiltering )
+    {
+    for (int i = first; i < end; ++i)
+      {
+      vtkMRMLLinearTransformNode* inputNode = internal->InputNodes[i];
+      vtkMRMLLinearTransformNode* outputNode = internal->OutputNodes[i];
+      if ( inputNode == NULL || outputNode == NULL || inputNode == outputNode
+        || ( !internal->IsInputModified( i, true ) && modifiedInputsOnly ) )
+        {
+        continue;
+        }
+      inputNode->GetMatrixTransformToParent( matrixCurrent );
+      internal->RecordSample( i, matrixCurrent, timestamp );
+      if ( !internal->QueueSample( i, matrixCurrent, timestamp ) && internal->Statistics[i] != NULL )
+        {
+        internal->Statistics[i]->AddDroppedSample();
+        }
+      }
+    this->PublishFilteredTransforms();
+    return;
+    }
+
+  // The clock is only read if at least one module node collects statistics
+  int numberOfTimedFilters = 0;
+  for (int i = first; i < end; ++i)
+    {
+    numberOfTimedFilters += ( internal->Statistics[i] != NULL ) ? 1 : 0;
+    }
+  const double startTime = ( numberOfTimedFilters > 0 ) ? vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() : 0.0;
+
+  // Gather the current input samples of the filters. Nodes are not thread-safe, so they
+  // are read on this thread. With modifiedInputsOnly, filters get no sample if their input
+  // transform is unchanged since their last sample.
+  for (int i = first; i < end; ++i)
+    {
+    vtkMRMLLinearTransformNode* inputNode = internal->InputNodes[i];
+    vtkMRMLLinearTransformNode* outputNode = internal->OutputNodes[i];
+    internal->ValidInputs[i] = ( inputNode != NULL && outputNode != NULL && inputNode != outputNode
+      && ( internal->IsInputModified( i, true ) || !modifiedInputsOnly ) );
+    if ( !internal->ValidInputs[i] )
+      {
+      continue;
+      }
+    inputNode->GetMatrixTransformToParent( matrixCurrent );
+    double rotation[4];
+    double translation[3];
+    vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( matrixCurrent->Element, rotation, translation );
+    internal->InputPoses.SetPose( i, rotation, translation );
+    internal->RecordSample( i, rotation, translation, timestamp );
+    }
+
+  // Filter the samples at once, in parallel
+  internal->Filters.SetSamples( timestamp, internal->InputPoses, internal->ValidInputs, first, count );
+  int numberOfFilteredSamples = 0;
+  for (int i = first; i < end; ++i)
+    {
+    if ( internal->Filters.HasSample( i ) )
+      {
+      ++numberOfFilteredSamples;
+      }
+    else if ( internal->ValidInputs[i] && internal->Statistics[i] != NULL )
+      {
+      internal->Statistics[i]->AddDroppedSample();
+      }
+    }
+
+  // Filters are updated in a single pass, so the filter time of each one is its share of the pass.
+  // Filters without a new sample (unchanged or invalid input) take no share.
+  const double filterTime = ( numberOfTimedFilters > 0 && numberOfFilteredSamples > 0 ) ?
+    ( vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - startTime ) / numberOfFilteredSamples : 0.0;
+
+  // Write the filtered poses, once all filters are updated. Observers of the filtered transforms
+  // are notified once all of them are written, so that they see a consistent scene.
+  internal->BeginOutputBatch();
+  for (int i = first; i < end; ++i)
+    {
+    if ( !internal->Filters.HasSample( i ) )
+      {
+      continue;
+      }
+    internal->AddToHistory( i, timestamp );
+    if ( !internal->Filters.GetFilterActivated( i ) )
+      {
+      // No filter. Output Transform = Input Transform
+      internal->InputNodes[i]->GetMatrixTransformToParent( matrixOutput );
+      }
+    else if ( !internal->GetResampledOutputMatrix( i, matrixOutput ) )
+      {
+      // Filtered, the output is written at the next output time
+      continue;
+      }
+    internal->WriteOutput( i, matrixOutput );
+    }
+  internal->EndOutputBatch();
+
+  if ( numberOfTimedFilters == 0 )
+    {
+    return;
+    }
+  // Latency includes the update of the observers of the filtered transforms
+  const double outputTime = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+  for (int i = first; i < end; ++i)
+    {
+    if ( internal->Filters.HasSample( i ) && internal->Statistics[i] != NULL )
+      {
+      internal->Statistics[i]->AddProcessedSample( filterTime, outputTime - timestamp );
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::SetBackgroundFiltering(bool background)
+{
+  if ( this->BackgroundFiltering == background )
+    {
+    return;
+    }
+  this->BackgroundFiltering = background;
+  if ( background )
+    {
+    this->Internal->StartWorker();
     }
   else
     {
-    // Compute interpolated matrix
-    this->GetInterpolatedTransform( matrixPrevious, matrixCurrent, weightPrevious, weightCurrent, matrixOutput );
+    this->Internal->SuspendWorker();
+    }
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerTransformSmootherLogic::PublishFilteredTransforms()
+{
+  if ( this->BackgroundFiltering )
+    {
+    this->Internal->PublishFilteredSamples();
+    }
+  this->Internal->WritePendingFusedOutputs();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic
+::SmoothTrajectory(vtkMRMLTransformSmootherNode* tsNode, vtkDoubleArray* timestamps,
+                   vtkDoubleArray* transforms, vtkDoubleArray* smoothedTransforms)
+{
+  if ( tsNode == NULL || timestamps == NULL || transforms == NULL || smoothedTransforms == NULL )
+    {
+    vtkErrorMacro( "SmoothTrajectory: Invalid inputs" );
+    return false;
+    }
+  if ( timestamps->GetNumberOfComponents() != 1 || transforms->GetNumberOfComponents() != 16
+    || timestamps->GetNumberOfTuples() != transforms->GetNumberOfTuples() )
+    {
+    vtkErrorMacro( "SmoothTrajectory: Expected one timestamp and one 4x4 matrix (16 components) per sample" );
+    return false;
     }
 
-  // Setting the TransformNode
-  outputNode->SetMatrixTransformToParent( matrixOutput );
+  vtkSlicerTransformSmootherZeroPhaseSmoother smoother;
+  smoother.SetCutOffFrequency( tsNode->GetCutOffFrequency() );
+  smoother.SetInterpolationMode( tsNode->GetInterpolationMode() );
+
+  const vtkIdType numberOfSamples = timestamps->GetNumberOfTuples();
+  smoothedTransforms->SetNumberOfComponents( 16 );
+  smoothedTransforms->SetNumberOfTuples( numberOfSamples );
+
+  double matrix[4][4];
+  double rotation[4];
+  double translation[3];
+  double timestamp = 0.0;
+  vtkIdType numberOfSmoothedSamples = 0;
+  for (vtkIdType i = 0; i <= numberOfSamples; ++i)
+    {
+    if ( i < numberOfSamples )
+      {
+      transforms->GetTuple( i, &matrix[0][0] );
+      vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( matrix, rotation, translation );
+      if ( !smoother.AddSample( timestamps->GetValue( i ), rotation, translation ) )
+        {
+        vtkErrorMacro( "SmoothTrajectory: Timestamps must increase, sample " << i << " is not newer than the previous one" );
+        return false;
+        }
+      }
+    else
+      {
+      smoother.Finish();
+      }
+
+    // Smoothed samples become available by chunks
+    while ( smoother.PopSample( timestamp, rotation, translation ) )
+      {
+      vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, matrix );
+      smoothedTransforms->SetTuple( numberOfSmoothedSamples++, &matrix[0][0] );
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::StartRecording(vtkMRMLTransformSmootherNode* tsNode, const char* filename)
+{
+  const int index = this->Internal->GetFilterIndex( tsNode );
+  if ( index < 0 )
+    {
+    vtkErrorMacro( "StartRecording: Module node is not in the scene of the logic" );
+    return false;
+    }
+  this->Internal->StopRecording( index );
+
+  vtkSlicerTransformSmootherTrajectoryWriter* recorder = new vtkSlicerTransformSmootherTrajectoryWriter;
+  if ( !recorder->Open( filename ) )
+    {
+    vtkErrorMacro( "StartRecording: Cannot create trajectory file " << ( filename ? filename : "(null)" ) );
+    delete recorder;
+    return false;
+    }
+  this->Internal->Recorders[index] = recorder;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::StopRecording(vtkMRMLTransformSmootherNode* tsNode)
+{
+  const int index = this->Internal->GetFilterIndex( tsNode );
+  if ( index < 0 || this->Internal->Recorders[index] == NULL )
+    {
+    return false;
+    }
+  if ( !this->Internal->StopRecording( index ) )
+    {
+    vtkErrorMacro( "StopRecording: Trajectory file could not be completely written" );
+    return false;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic::IsRecording(vtkMRMLTransformSmootherNode* tsNode)
+{
+  const int index = this->Internal->GetFilterIndex( tsNode );
+  return index >= 0 && this->Internal->Recorders[index] != NULL;
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkSlicerTransformSmootherLogic
+::ReplayTrajectory(vtkMRMLTransformSmootherNode* tsNode, const char* filename, vtkDoubleArray* filteredTransforms)
+{
+  if ( this->Internal->GetFilterIndex( tsNode ) < 0 )
+    {
+    vtkErrorMacro( "ReplayTrajectory: Module node is not in the scene of the logic" );
+    return -1;
+    }
+  if ( this->BackgroundFiltering )
+    {
+    vtkErrorMacro( "ReplayTrajectory: Not available while background filtering is enabled" );
+    return -1;
+    }
+
+  vtkSlicerTransformSmootherTrajectoryReader reader;
+  if ( !reader.Open( filename ) )
+    {
+    vtkErrorMacro( "ReplayTrajectory: Cannot read trajectory file " << ( filename ? filename : "(null)" ) );
+    return -1;
+    }
+
+  const vtkIdType numberOfRecords = static_cast<vtkIdType>( reader.GetNumberOfRecords() );
+  if ( filteredTransforms != NULL )
+    {
+    filteredTransforms->SetNumberOfComponents( 16 );
+    filteredTransforms->SetNumberOfTuples( numberOfRecords );
+    }
+
+  // Records are read in place from the mapped file
+  const vtkSlicerTransformSmootherTrajectoryFormat::Record* records = reader.GetRecords();
+  vtkMatrix4x4* matrixCurrent = this->Internal->InputMatrix.GetPointer();
+  vtkMatrix4x4* matrixOutput = this->Internal->OutputMatrix.GetPointer();
+  vtkIdType numberOfFilteredSamples = 0;
+  for (vtkIdType i = 0; i < numberOfRecords; ++i)
+    {
+    vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( records[i].Rotation, records[i].Translation,
+      matrixCurrent->Element );
+    matrixCurrent->Modified();
+    if ( !this->ProcessSample( tsNode, matrixCurrent, records[i].Timestamp, matrixOutput ) )
+      {
+      continue;
+      }
+    if ( filteredTransforms != NULL )
+      {
+      filteredTransforms->SetTuple( numberOfFilteredSamples, &matrixOutput->Element[0][0] );
+      }
+    ++numberOfFilteredSamples;
+    }
+  if ( filteredTransforms != NULL )
+    {
+    filteredTransforms->SetNumberOfTuples( numberOfFilteredSamples );
+    }
+
+  const int index = this->Internal->GetFilterIndex( tsNode );
+  vtkMRMLLinearTransformNode* outputNode = this->Internal->OutputNodes[index];
+  if ( numberOfFilteredSamples > 0 && outputNode != NULL && outputNode != this->Internal->InputNodes[index] )
+    {
+    this->Internal->WriteOutput( index, matrixOutput );
+    }
+  return numberOfFilteredSamples;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerTransformSmootherLogic
+::GetTransformAtTime(vtkMRMLTransformSmootherNode* tsNode, double timestamp, vtkMatrix4x4* matrix, int channel)
+{
+  vtkInternal* internal = this->Internal;
+  int first = 0;
+  int count = 0;
+  if ( !internal->GetFilterRange( tsNode, first, count ) || channel < 0 || channel >= count || matrix == NULL )
+    {
+    return false;
+    }
+  const int index = first + channel;
+  if ( internal->Histories[index] == NULL )
+    {
+    return false;
+    }
+
+  // Include the samples filtered by the worker thread
+  this->PublishFilteredTransforms();
+
+  const vtkSlicerTransformSmootherPoseHistory* history = internal->Histories[index];
+  int before = 0;
+  int after = 0;
+  double weight = 0.0;
+  if ( !history->FindPoses( timestamp, before, after, weight ) )
+    {
+    return false;
+    }
+
+  double poseTimestamp = 0.0;
+  double rotation[4];
+  double translation[3];
+  vtkMatrix4x4* matrixBefore = internal->HistoryMatrixBefore.GetPointer();
+  history->GetPose( before, poseTimestamp, rotation, translation );
+  vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, matrixBefore->Element );
+  vtkMatrix4x4* matrixAfter = internal->HistoryMatrixAfter.GetPointer();
+  history->GetPose( after, poseTimestamp, rotation, translation );
+  vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, matrixAfter->Element );
+
+  // Only the rigid part is interpolated, the last row stays that of the identity
+  matrix->Identity();
+  this->GetInterpolatedTransform( matrixBefore, matrixAfter, 1.0 - weight, weight, matrix );
+  matrix->Modified();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkSlicerTransformSmootherLogic::GetNumberOfSuppressedWrites(vtkMRMLTransformSmootherNode* tsNode)
+{
+  int first = 0;
+  int count = 0;
+  if ( !this->Internal->GetFilterRange( tsNode, first, count ) )
+    {
+    return 0;
+    }
+  vtkIdType numberOfSuppressedWrites = 0;
+  for (int i = first; i < first + count; ++i)
+    {
+    numberOfSuppressedWrites += this->Internal->SuppressedWrites[i];
+    }
+  return numberOfSuppressedWrites;
 }
@@ -37,6 +37,7 @@
 
 #include "vtkSlicerTransformSmootherModuleLogicExport.h"
 
+class vtkDoubleArray;
 class vtkMatrix4x4;
 
 /// \ingroup Slicer_QtModules_ExtensionTemplate
@@ -51,8 +52,147 @@ public:
 
   void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData);
 
+  enum
+    {
+    // Invoked when FilterChannel leaves fused outputs to be written by PublishFilteredTransforms,
+    // so that they can be written once at the end of the tick (e.g. of the event loop iteration).
+    FusedOutputsPendingEvent = 21002
+    };
+
+  /// Filter the current input transforms of all channels of tsNode and write the results to their
+  /// filtered transforms (see vtkMRMLTransformSmootherNode::AddChannel). Channels are filtered in a single pass.
+  /// The sample is timestamped with the time of the call (see GetCurrentTimestamp).
+  /// If the module node has an output rate, every sample is filtered but the filtered transform
+  /// is only written at that rate (see vtkMRMLTransformSmootherNode::SetOutputRate).
+  /// Filtered transforms within the output deadband of the module node are not written either
+  /// (see GetNumberOfSuppressedWrites).
   void Filter(vtkMRMLTransformSmootherNode* tsNode);
 
+  /// Same as Filter(tsNode) but uses the acquisition timestamp of the input sample (in seconds),
+  /// e.g. the timestamp provided by the tracking device. Timestamps of successive samples of a
+  /// module node must use the same time reference.
+  /// If the module node collects statistics, its input-to-output latency is measured from timestamp,
+  /// which is then expected to be in the time reference of GetCurrentTimestamp.
+  void Filter(vtkMRMLTransformSmootherNode* tsNode, double timestamp);
+
+  /// Filter the current input transform of one channel of tsNode and write the result to its filtered transform.
+  /// Called automatically each time the input transform node of a channel of an observed module node is modified,
+  /// so that only the channel that has a new sample is filtered.
+  /// A filtered transform node shared with other filters (see vtkMRMLTransformSmootherNode::SetFusionWeight) is
+  /// not written by FilterChannel: the fused output is marked pending and FusedOutputsPendingEvent is invoked,
+  /// and the next PublishFilteredTransforms writes it once, with the weighted average of the latest filtered
+  /// transforms of all its filters. The Qt module publishes at the end of the event loop iteration, so the
+  /// fused output is written once per tick, whatever the number of its inputs modified in the tick.
+  void FilterChannel(vtkMRMLTransformSmootherNode* tsNode, int channel, double timestamp);
+
+  /// Feed one input sample (acquired at timestamp, in seconds) into the filter of the first channel of tsNode and
+  /// compute the filtered transform in outputMatrix, without modifying the scene.
+  /// Once the filter state of tsNode exists (after its first sample) no heap allocation is performed.
+  /// Returns false if no output is available for this sample (e.g. sample is not newer than the previous one).
+  /// Statistics of tsNode are not updated, they are collected by Filter and FilterAll.
+  /// The filtered pose is added to the pose history of tsNode (see GetTransformAtTime).
+  /// The output rate of tsNode does not apply, the filtered transform of every sample is computed.
+  /// Not available while background filtering is enabled, as the filters are then owned by the worker thread.
+  bool ProcessSample(vtkMRMLTransformSmootherNode* tsNode, vtkMatrix4x4* inputMatrix,
+                     double timestamp, vtkMatrix4x4* outputMatrix);
+
+  /// Filter the current input transforms of all module nodes of the scene in a single pass
+  /// and write the results to their filtered transforms. All samples are timestamped with
+  /// the time of the call (see GetCurrentTimestamp).
+  /// Filters are updated in parallel by the vtkSMPTools backend (e.g. TBB), the transform
+  /// nodes are read before and written after the parallel update, on the calling thread.
+  /// Modified events of the filtered transform nodes are deferred until all of them are written,
+  /// so that their observers (e.g. transformed models, rendering) see the update of the whole pass at once.
+  /// This only applies to FilterAll and PublishFilteredTransforms (and to the channels of one Filter call):
+  /// when filtering is driven by the modified events of the input transforms, each event writes and notifies
+  /// its filtered transform right away, so observers may see the filtered transforms of a tick partially updated.
+  /// A filtered transform node shared by several module nodes (or channels) is written once per pass,
+  /// with the weighted average of their latest filtered transforms (see vtkMRMLTransformSmootherNode::SetFusionWeight).
+  /// Only filters whose input transform was modified since their last sample get a new sample, so that
+  /// an unchanged input is not filtered again as a new sample. Inputs modified with their modified events
+  /// enabled are already filtered by the modified event (see FilterChannel): FilterAll then only filters
+  /// the inputs modified without events (e.g. with SetDisableModifiedEvent).
+  /// Filter and FilterChannel filter the current input transforms even if they were not modified.
+  void FilterAll();
+
+  /// Same as FilterAll() but uses the given timestamp (in seconds) for all samples.
+  void FilterAll(double timestamp);
+
+  /// Filter samples on a background worker thread, so that filtering is not delayed by
+  /// rendering or other work on the main thread (off by default).
+  /// Filter and FilterAll then only queue the input samples (and filter parameter changes)
+  /// in a lock-free queue, the worker filters them in order, and the filtered transforms are
+  /// written to the scene on the main thread by PublishFilteredTransforms. Results are the same
+  /// as with foreground filtering. Only the rigid part of the input transforms is propagated
+  /// when the filter is not activated.
+  /// Samples that do not fit in the queue are dropped, the main thread never waits for the worker,
+  /// except when module nodes are added or removed, as filters are then synchronized.
+  void SetBackgroundFiltering(bool background);
+  vtkGetMacro(BackgroundFiltering, bool);
+  vtkBooleanMacro(BackgroundFiltering, bool);
+
+  /// Write the transforms filtered by the worker thread to the filtered transform nodes.
+  /// Only the latest filtered transform of each module node is written.
+  /// Fused outputs left pending by FilterChannel are written too, once per output node, also
+  /// when background filtering is disabled (see FusedOutputsPendingEvent).
+  /// As with FilterAll, modified events are invoked once all filtered transforms are written.
+  /// Must be called on the main thread. Filter calls it after queueing each sample and the
+  /// Qt module calls it periodically while background filtering is enabled (see SetBackgroundFiltering,
+  /// which invokes a modified event), and after FusedOutputsPendingEvent.
+  void PublishFilteredTransforms();
+
+  /// Offline zero-phase smoothing of a recorded trajectory: the low-pass filter (cutoff frequency
+  /// and interpolation mode of tsNode) is run forwards then backwards in time, so that the smoothed
+  /// trajectory has no lag (see vtkSlicerTransformSmootherZeroPhaseSmoother).
+  /// timestamps has one component (in seconds, increasing). transforms and smoothedTransforms hold
+  /// one homogeneous transformation matrix per tuple (16 components, row by row); only the rigid
+  /// part of the transforms is smoothed. The trajectory is processed in chunks, so the working memory
+  /// does not depend on its length. Returns false if the inputs are invalid.
+  bool SmoothTrajectory(vtkMRMLTransformSmootherNode* tsNode, vtkDoubleArray* timestamps,
+                        vtkDoubleArray* transforms, vtkDoubleArray* smoothedTransforms);
+
+  /// Record the input samples of tsNode to a binary trajectory file (see vtkSlicerTransformSmootherTrajectoryFormat)
+  /// until StopRecording is called or the module node is removed. Samples are recorded with their timestamp
+  /// as they are filtered by Filter and FilterAll, i.e. each time the input transform node is modified.
+  /// Records are written to the file in large blocks, so recording does not slow down live filtering.
+  /// A recording in progress for tsNode is stopped first. Returns false if the file cannot be created.
+  bool StartRecording(vtkMRMLTransformSmootherNode* tsNode, const char* filename);
+
+  /// Complete and close the trajectory file of tsNode.
+  /// Returns false if tsNode was not recorded or the file could not be completely written.
+  bool StopRecording(vtkMRMLTransformSmootherNode* tsNode);
+
+  bool IsRecording(vtkMRMLTransformSmootherNode* tsNode);
+
+  /// Feed all samples of a trajectory file, in order, into the filter of tsNode (see ProcessSample)
+  /// and write the last filtered transform to its filtered transform node. The file is memory-mapped,
+  /// so its size is not limited by the available memory. If filteredTransforms is not NULL, it is set
+  /// to the filtered transform of each sample that produced an output (16 components, row by row).
+  /// Returns the number of filtered samples, -1 if the file cannot be read.
+  /// Not available while background filtering is enabled.
+  vtkIdType ReplayTrajectory(vtkMRMLTransformSmootherNode* tsNode, const char* filename,
+                             vtkDoubleArray* filteredTransforms = NULL);
+
+  /// Filtered transform of tsNode at a past time (in seconds, in the time reference of the sample
+  /// timestamps), interpolated between the two filtered poses around timestamp in the pose history of
+  /// tsNode (see vtkMRMLTransformSmootherNode::SetPoseHistoryLength). Every filtered sample is kept,
+  /// regardless of the output rate. The lookup time is logarithmic in the history length and no heap
+  /// allocation is performed. Returns false if tsNode has no pose history or timestamp is outside of it.
+  /// Each channel of tsNode has its own pose history.
+  bool GetTransformAtTime(vtkMRMLTransformSmootherNode* tsNode, double timestamp, vtkMatrix4x4* matrix, int channel = 0);
+
+  /// Number of filtered transforms of tsNode (all channels) that were not written because they were within its output
+  /// deadband (see vtkMRMLTransformSmootherNode::SetOutputTranslationDeadband), since it was added to the scene
+  /// or its channels changed.
+  vtkIdType GetNumberOfSuppressedWrites(vtkMRMLTransformSmootherNode* tsNode);
+
+  /// Current time of a monotonic high-resolution clock, in seconds
+  static double GetCurrentTimestamp();
+
+  /// Spherical linear interpolation between two rotation quaternions (w, x, y, z).
+  /// See vtkSlicerTransformSmootherBatchKernels::Slerp for interpolating many pairs at once.
+  static void Slerp(double* result, double t, double* from, double* to, bool adjustSign = true);
+
 protected:
   vtkSlicerTransformSmootherLogic();
   virtual ~vtkSlicerTransformSmootherLogic();
@@ -61,15 +201,34 @@ protected:
   /// Register MRML Node classes to Scene. Gets called automatically when the MRMLScene is attached to this logic class.
   virtual void RegisterNodes();
   virtual void UpdateFromMRMLScene();
+  virtual void OnMRMLSceneEndBatchProcess();
   virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
   virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
 
-  void Slerp(double* result, double t, double* from, double* to, bool adjustSign = true);
   void GetInterpolatedTransform(vtkMatrix4x4* itemAmatrix, vtkMatrix4x4* itemBmatrix,
 				double itemAweight, double itemBweight,
 				vtkMatrix4x4* interpolatedMatrix);
+  /// Compute the weight of the new sample of a first-order low-pass filter
+  /// from the elapsed time since the previous sample and the cutoff frequency.
+  static double GetSmoothingFactor(double dt, double cutoffFrequency);
+
+  /// Set a new input sample of the filter at index and compute its smoothing factor.
+  /// If smooth is true the filtered pose is updated right away, otherwise it is updated
+  /// with all other filters. Returns false if the sample is not newer than the previous one.
+  bool SetFilterSample(int index, vtkMatrix4x4* inputMatrix, double timestamp, bool smooth = true);
+
+  /// Filter the current input transforms of count consecutive filters, starting at index first, in a single pass
+  /// and write the results (see FilterAll). The filters of the channels of a module node are consecutive.
+  /// If modifiedInputsOnly is true, filters whose input transform was not modified since their last sample are skipped.
+  void FilterRange(int first, int count, double timestamp, bool modifiedInputsOnly = false);
+
 private:
 
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  bool BackgroundFiltering;
+
   vtkSlicerTransformSmootherLogic(const vtkSlicerTransformSmootherLogic&); // Not implemented
   void operator=(const vtkSlicerTransformSmootherLogic&); // Not implemented
 };
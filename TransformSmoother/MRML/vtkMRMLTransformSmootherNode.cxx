@@ -27,6 +27,7 @@
 #include <vtkCommand.h>
 
 // Other includes
+#include <algorithm>
 #include <sstream>
 
 // Constants
@@ -45,11 +46,29 @@ vtkMRMLTransformSmootherNode
   vtkNew<vtkIntArray> events;
   events->InsertNextValue( vtkCommand::ModifiedEvent );
 
+  this->InputTransformRoles.push_back( INPUT_TRANSFORM_ROLE );
+  this->FilteredTransformRoles.push_back( FILTERED_TRANSFORM_ROLE );
   this->AddNodeReferenceRole( INPUT_TRANSFORM_ROLE, NULL, events.GetPointer() );
   this->AddNodeReferenceRole( FILTERED_TRANSFORM_ROLE, NULL, events.GetPointer() );
+  this->NumberOfChannels = 0;
+  this->InputChannelsModified = true;
 
   this->CutOffFrequency = 7.5;
   this->FilterActivated = false;
+  this->FilterMode = FilterLowPass;
+  this->FilterOrder = 2;
+  this->MinCutOffFrequency = 1.0;
+  this->Beta = 0.05;
+  this->PredictionTime = 0.0;
+  this->ProcessNoise = 500.0;
+  this->MeasurementNoise = 0.2;
+  this->InterpolationMode = InterpolationPolynomialSlerp;
+  this->OutputRate = 0.0;
+  this->OutputTranslationDeadband = 0.0;
+  this->OutputRotationDeadband = 0.0;
+  this->FusionWeight = 1.0;
+  this->PoseHistoryLength = 0;
+  this->StatisticsEnabled = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -67,6 +86,21 @@ void vtkMRMLTransformSmootherNode
 
   of << indent << " cutoffFrequency=\"" << this->CutOffFrequency << "\"";
   of << indent << " filterActivated=\"" << ( this->FilterActivated ? "true" : "false" ) << "\"";
+  of << indent << " filterMode=\"" << GetFilterModeAsString( this->FilterMode ) << "\"";
+  of << indent << " filterOrder=\"" << this->FilterOrder << "\"";
+  of << indent << " minCutoffFrequency=\"" << this->MinCutOffFrequency << "\"";
+  of << indent << " beta=\"" << this->Beta << "\"";
+  of << indent << " predictionTime=\"" << this->PredictionTime << "\"";
+  of << indent << " processNoise=\"" << this->ProcessNoise << "\"";
+  of << indent << " measurementNoise=\"" << this->MeasurementNoise << "\"";
+  of << indent << " interpolationMode=\"" << GetInterpolationModeAsString( this->InterpolationMode ) << "\"";
+  of << indent << " outputRate=\"" << this->OutputRate << "\"";
+  of << indent << " outputTranslationDeadband=\"" << this->OutputTranslationDeadband << "\"";
+  of << indent << " outputRotationDeadband=\"" << this->OutputRotationDeadband << "\"";
+  of << indent << " fusionWeight=\"" << this->FusionWeight << "\"";
+  of << indent << " poseHistoryLength=\"" << this->PoseHistoryLength << "\"";
+  of << indent << " numberOfChannels=\"" << this->NumberOfChannels << "\"";
+  of << indent << " statisticsEnabled=\"" << ( this->StatisticsEnabled ? "true" : "false" ) << "\"";
 }
 
 //-----------------------------------------------------------------------------
@@ -103,6 +137,133 @@ void vtkMRMLTransformSmootherNode
 	this->FilterActivated = false;
 	}
       }
+    else if(!strcmp(attName, "filterMode"))
+      {
+      int mode = GetFilterModeFromString( attValue );
+      if ( mode >= 0 )
+        {
+        this->FilterMode = mode;
+        }
+      else
+        {
+        vtkWarningMacro( "ReadXMLAttributes: Unknown filter mode " << attValue );
+        }
+      }
+    else if (!strcmp(attName, "filterOrder"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      int val;
+      ss >> val;
+      this->FilterOrder = ( val > 2 ) ? 4 : 2;
+      }
+    else if (!strcmp(attName, "minCutoffFrequency"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->MinCutOffFrequency = val;
+      }
+    else if (!strcmp(attName, "beta"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->Beta = val;
+      }
+    else if (!strcmp(attName, "predictionTime"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->PredictionTime = val;
+      }
+    else if (!strcmp(attName, "processNoise"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->ProcessNoise = val;
+      }
+    else if (!strcmp(attName, "measurementNoise"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->MeasurementNoise = val;
+      }
+    else if(!strcmp(attName, "interpolationMode"))
+      {
+      int mode = GetInterpolationModeFromString( attValue );
+      if ( mode >= 0 )
+        {
+        this->InterpolationMode = mode;
+        }
+      else
+        {
+        vtkWarningMacro( "ReadXMLAttributes: Unknown interpolation mode " << attValue );
+        }
+      }
+    else if (!strcmp(attName, "outputRate"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->OutputRate = ( val > 0.0 ) ? val : 0.0;
+      }
+    else if (!strcmp(attName, "outputTranslationDeadband"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->OutputTranslationDeadband = ( val > 0.0 ) ? val : 0.0;
+      }
+    else if (!strcmp(attName, "outputRotationDeadband"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->OutputRotationDeadband = ( val > 0.0 ) ? ( ( val < 180.0 ) ? val : 180.0 ) : 0.0;
+      }
+    else if (!strcmp(attName, "fusionWeight"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      double val;
+      ss >> val;
+      this->FusionWeight = ( val > 0.0 ) ? val : 0.0;
+      }
+    else if (!strcmp(attName, "poseHistoryLength"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      int val;
+      ss >> val;
+      this->PoseHistoryLength = ( val > 0 ) ? val : 0;
+      }
+    else if (!strcmp(attName, "numberOfChannels"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      int val;
+      ss >> val;
+      this->NumberOfChannels = ( val > 0 ) ? val : 0;
+      this->InputChannelsModified = true;
+      // Roles of the channels must be known before the references are updated
+      this->AddChannelRoles( this->NumberOfChannels );
+      }
+    else if(!strcmp(attName, "statisticsEnabled"))
+      {
+      this->StatisticsEnabled = !strcmp( attValue, "true" );
+      }
     }
 }
 
@@ -116,6 +277,23 @@ void vtkMRMLTransformSmootherNode
 
   this->CutOffFrequency = node->CutOffFrequency;
   this->FilterActivated = node->FilterActivated;
+  this->FilterMode = node->FilterMode;
+  this->FilterOrder = node->FilterOrder;
+  this->MinCutOffFrequency = node->MinCutOffFrequency;
+  this->Beta = node->Beta;
+  this->PredictionTime = node->PredictionTime;
+  this->ProcessNoise = node->ProcessNoise;
+  this->MeasurementNoise = node->MeasurementNoise;
+  this->InterpolationMode = node->InterpolationMode;
+  this->OutputRate = node->OutputRate;
+  this->OutputTranslationDeadband = node->OutputTranslationDeadband;
+  this->OutputRotationDeadband = node->OutputRotationDeadband;
+  this->FusionWeight = node->FusionWeight;
+  this->PoseHistoryLength = node->PoseHistoryLength;
+  this->StatisticsEnabled = node->StatisticsEnabled;
+  this->NumberOfChannels = node->NumberOfChannels;
+  this->InputChannelsModified = true;
+  this->AddChannelRoles( this->NumberOfChannels );
 
   this->Modified();
 }
@@ -130,73 +308,381 @@ void vtkMRMLTransformSmootherNode
   os << indent << "FilteredTransformNodeID: " << this->GetFilteredTransformNode()->GetID() << std::endl;
   os << indent << "CutOff Frequency: " << this->CutOffFrequency << std::endl;
   os << indent << "Filter Activated: " << this->FilterActivated << std::endl;
+  os << indent << "Filter Mode: " << GetFilterModeAsString( this->FilterMode ) << std::endl;
+  os << indent << "Filter Order: " << this->FilterOrder << std::endl;
+  os << indent << "Min CutOff Frequency: " << this->MinCutOffFrequency << std::endl;
+  os << indent << "Beta: " << this->Beta << std::endl;
+  os << indent << "Prediction Time: " << this->PredictionTime << std::endl;
+  os << indent << "Process Noise: " << this->ProcessNoise << std::endl;
+  os << indent << "Measurement Noise: " << this->MeasurementNoise << std::endl;
+  os << indent << "Interpolation Mode: " << GetInterpolationModeAsString( this->InterpolationMode ) << std::endl;
+  os << indent << "Output Rate: " << this->OutputRate << std::endl;
+  os << indent << "Output Translation Deadband: " << this->OutputTranslationDeadband << std::endl;
+  os << indent << "Output Rotation Deadband: " << this->OutputRotationDeadband << std::endl;
+  os << indent << "Fusion Weight: " << this->FusionWeight << std::endl;
+  os << indent << "Pose History Length: " << this->PoseHistoryLength << std::endl;
+  os << indent << "Statistics Enabled: " << this->StatisticsEnabled << std::endl;
+  os << indent << "Number Of Channels: " << this->GetNumberOfChannels() << std::endl;
+  os << indent << "Statistics: ";
+  this->Statistics.Print( os );
+  os << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::ResetStatistics()
+{
+  this->Statistics.Reset();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::SetFilterOrder( int order )
+{
+  // Only orders made of whole biquad sections are supported
+  order = ( order > 2 ) ? 4 : 2;
+  if ( this->FilterOrder == order )
+    {
+    return;
+    }
+  this->FilterOrder = order;
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+const char* vtkMRMLTransformSmootherNode
+::GetFilterModeAsString( int mode )
+{
+  switch ( mode )
+    {
+    case FilterLowPass: return "LowPass";
+    case FilterOneEuro: return "OneEuro";
+    case FilterButterworth: return "Butterworth";
+    case FilterKalman: return "Kalman";
+    default: return "";
+    }
+}
+
+//-----------------------------------------------------------------------------
+int vtkMRMLTransformSmootherNode
+::GetFilterModeFromString( const char* name )
+{
+  if ( name == NULL )
+    {
+    return -1;
+    }
+  for (int mode = 0; mode < FilterMode_Last; ++mode)
+    {
+    if ( !strcmp( name, GetFilterModeAsString( mode ) ) )
+      {
+      return mode;
+      }
+    }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+const char* vtkMRMLTransformSmootherNode
+::GetInterpolationModeAsString( int mode )
+{
+  switch ( mode )
+    {
+    case InterpolationSlerp: return "Slerp";
+    case InterpolationPolynomialSlerp: return "PolynomialSlerp";
+    case InterpolationNlerp: return "Nlerp";
+    default: return "";
+    }
+}
+
+//-----------------------------------------------------------------------------
+int vtkMRMLTransformSmootherNode
+::GetInterpolationModeFromString( const char* name )
+{
+  if ( name == NULL )
+    {
+    return -1;
+    }
+  for (int mode = 0; mode < InterpolationMode_Last; ++mode)
+    {
+    if ( !strcmp( name, GetInterpolationModeAsString( mode ) ) )
+      {
+      return mode;
+      }
+    }
+  return -1;
 }
 
 //-----------------------------------------------------------------------------
 vtkMRMLLinearTransformNode* vtkMRMLTransformSmootherNode
 ::GetInputTransformNode()
 {
-  vtkMRMLLinearTransformNode* inputNode = vtkMRMLLinearTransformNode::SafeDownCast(
-    this->GetNodeReference( INPUT_TRANSFORM_ROLE ) );
-  return inputNode;
+  return this->GetNthInputTransformNode( 0 );
 }
 
 //-----------------------------------------------------------------------------
 void vtkMRMLTransformSmootherNode
 ::SetAndObserveInputTransformNodeID( const char* inputNodeId )
 {
-  // SetAndObserveNodeReferenceID does not handle nicely setting of the same
-  // node (it should simply ignore the request, but it adds another observer instead)
-  // so check for node equality here.
+  this->SetAndObserveNthInputTransformNodeID( 0, inputNodeId );
+}
+
+//-----------------------------------------------------------------------------
+vtkMRMLLinearTransformNode* vtkMRMLTransformSmootherNode
+::GetFilteredTransformNode()
+{
+  return this->GetNthFilteredTransformNode( 0 );
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::SetAndObserveFilteredTransformNodeID( const char* filteredNodeId )
+{
+  this->SetAndObserveNthFilteredTransformNodeID( 0, filteredNodeId );
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::ProcessMRMLEvents( vtkObject *caller, unsigned long event, void* callData )
+{
+  Superclass::ProcessMRMLEvents( caller, event, callData );
+
+  if ( event != vtkCommand::ModifiedEvent || caller == NULL )
+    {
+    return;
+    }
+
+  // Forward input transform modifications so that the logic can filter the new sample.
+  // Modifications of the filtered transforms are ignored, they are caused by the filter itself.
+  // Called for each sample: the channels of the caller are found by a binary search, without
+  // reference lookups or allocations.
+  if ( this->InputChannelsModified )
+    {
+    this->UpdateInputChannels();
+    }
+  for (std::vector< InputChannelType >::const_iterator it = std::lower_bound( this->InputChannels.begin(),
+    this->InputChannels.end(), InputChannelType( caller, -1 ) );
+    it != this->InputChannels.end() && it->first == caller; ++it)
+    {
+    int channel = it->second;
+    this->InvokeEvent( vtkMRMLTransformSmootherNode::InputDataModifiedEvent, &channel );
+    }
+}
 
-  const char* currentNodeId = this->GetNodeReferenceID(INPUT_TRANSFORM_ROLE);
-  if (inputNodeId != NULL && currentNodeId != NULL)
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::UpdateInputChannels()
+{
+  this->InputChannels.clear();
+  this->InputChannelsModified = false;
+  const int numberOfChannels = this->GetNumberOfChannels();
+  for (int channel = 0; channel < numberOfChannels; ++channel)
     {
-    if (strcmp(inputNodeId, currentNodeId) == 0)
+    vtkMRMLLinearTransformNode* inputNode = this->GetNthInputTransformNode( channel );
+    if ( inputNode == NULL )
+      {
+      // Input node not in the scene yet, update again at the next event
+      this->InputChannelsModified = this->InputChannelsModified
+        || ( this->GetNodeReferenceID( this->GetInputTransformRole( channel ) ) != NULL );
+      continue;
+      }
+    if ( inputNode != this->GetNthFilteredTransformNode( channel ) )
       {
-      // not changed
-      return;
+      this->InputChannels.push_back( InputChannelType( inputNode, channel ) );
       }
     }
+  std::sort( this->InputChannels.begin(), this->InputChannels.end() );
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::OnNodeReferenceAdded( vtkMRMLNodeReference* reference )
+{
+  this->InputChannelsModified = true;
+  Superclass::OnNodeReferenceAdded( reference );
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::OnNodeReferenceModified( vtkMRMLNodeReference* reference )
+{
+  this->InputChannelsModified = true;
+  Superclass::OnNodeReferenceModified( reference );
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::OnNodeReferenceRemoved( vtkMRMLNodeReference* reference )
+{
+  this->InputChannelsModified = true;
+  Superclass::OnNodeReferenceRemoved( reference );
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::AddChannelRoles( int numberOfChannels )
+{
+  // Called for each forwarded input event, must not allocate once the roles exist
+  if ( static_cast<int>( this->InputTransformRoles.size() ) >= numberOfChannels )
+    {
+    return;
+    }
   vtkNew<vtkIntArray> events;
   events->InsertNextValue( vtkCommand::ModifiedEvent );
-  this->SetAndObserveNodeReferenceID( INPUT_TRANSFORM_ROLE, inputNodeId, events.GetPointer() );
+  for (int channel = static_cast<int>( this->InputTransformRoles.size() ); channel < numberOfChannels; ++channel)
+    {
+    std::stringstream inputRole;
+    inputRole << INPUT_TRANSFORM_ROLE << channel;
+    this->InputTransformRoles.push_back( inputRole.str() );
+    this->AddNodeReferenceRole( this->InputTransformRoles.back().c_str(), NULL, events.GetPointer() );
+    std::stringstream filteredRole;
+    filteredRole << FILTERED_TRANSFORM_ROLE << channel;
+    this->FilteredTransformRoles.push_back( filteredRole.str() );
+    this->AddNodeReferenceRole( this->FilteredTransformRoles.back().c_str(), NULL, events.GetPointer() );
+    }
+}
+
+//-----------------------------------------------------------------------------
+const char* vtkMRMLTransformSmootherNode
+::GetInputTransformRole( int channel )
+{
+  if ( channel < 0 )
+    {
+    return NULL;
+    }
+  this->AddChannelRoles( channel + 1 );
+  return this->InputTransformRoles[channel].c_str();
+}
+
+//-----------------------------------------------------------------------------
+const char* vtkMRMLTransformSmootherNode
+::GetFilteredTransformRole( int channel )
+{
+  if ( channel < 0 )
+    {
+    return NULL;
+    }
+  this->AddChannelRoles( channel + 1 );
+  return this->FilteredTransformRoles[channel].c_str();
+}
+
+//-----------------------------------------------------------------------------
+int vtkMRMLTransformSmootherNode
+::GetNumberOfChannels()
+{
+  // Scenes saved before channels were introduced only have the references of channel 0
+  if ( this->NumberOfChannels == 0
+    && ( this->GetNodeReferenceID( INPUT_TRANSFORM_ROLE ) != NULL || this->GetNodeReferenceID( FILTERED_TRANSFORM_ROLE ) != NULL ) )
+    {
+    return 1;
+    }
+  return this->NumberOfChannels;
 }
 
 //-----------------------------------------------------------------------------
 vtkMRMLLinearTransformNode* vtkMRMLTransformSmootherNode
-::GetFilteredTransformNode()
+::GetNthInputTransformNode( int channel )
 {
-  vtkMRMLLinearTransformNode* filteredNode = vtkMRMLLinearTransformNode::SafeDownCast(
-    this->GetNodeReference( FILTERED_TRANSFORM_ROLE ) );
-  return filteredNode;
+  if ( channel < 0 || channel >= this->GetNumberOfChannels() )
+    {
+    return NULL;
+    }
+  return vtkMRMLLinearTransformNode::SafeDownCast( this->GetNodeReference( this->GetInputTransformRole( channel ) ) );
 }
 
 //-----------------------------------------------------------------------------
 void vtkMRMLTransformSmootherNode
-::SetAndObserveFilteredTransformNodeID( const char* filteredNodeId )
+::SetAndObserveNthInputTransformNodeID( int channel, const char* inputNodeId )
 {
+  const char* role = this->GetInputTransformRole( channel );
+  if ( role == NULL )
+    {
+    return;
+    }
   // SetAndObserveNodeReferenceID does not handle nicely setting of the same
   // node (it should simply ignore the request, but it adds another observer instead)
   // so check for node equality here.
+  const char* currentNodeId = this->GetNodeReferenceID( role );
+  if ( inputNodeId != NULL && currentNodeId != NULL && strcmp( inputNodeId, currentNodeId ) == 0 )
+    {
+    return;
+    }
+  if ( inputNodeId != NULL && channel >= this->NumberOfChannels )
+    {
+    this->NumberOfChannels = channel + 1;
+    this->InputChannelsModified = true;
+    }
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue( vtkCommand::ModifiedEvent );
+  this->SetAndObserveNodeReferenceID( role, inputNodeId, events.GetPointer() );
+}
 
-  const char* currentNodeId = this->GetNodeReferenceID(FILTERED_TRANSFORM_ROLE);
-  if (filteredNodeId != NULL && currentNodeId != NULL)
+//-----------------------------------------------------------------------------
+vtkMRMLLinearTransformNode* vtkMRMLTransformSmootherNode
+::GetNthFilteredTransformNode( int channel )
+{
+  if ( channel < 0 || channel >= this->GetNumberOfChannels() )
     {
-    if (strcmp(filteredNodeId, currentNodeId) == 0)
-      {
-      // not changed
-      return;
-      }
+    return NULL;
+    }
+  return vtkMRMLLinearTransformNode::SafeDownCast( this->GetNodeReference( this->GetFilteredTransformRole( channel ) ) );
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLTransformSmootherNode
+::SetAndObserveNthFilteredTransformNodeID( int channel, const char* filteredNodeId )
+{
+  const char* role = this->GetFilteredTransformRole( channel );
+  if ( role == NULL )
+    {
+    return;
+    }
+  // Same node is ignored, see SetAndObserveNthInputTransformNodeID
+  const char* currentNodeId = this->GetNodeReferenceID( role );
+  if ( filteredNodeId != NULL && currentNodeId != NULL && strcmp( filteredNodeId, currentNodeId ) == 0 )
+    {
+    return;
+    }
+  if ( filteredNodeId != NULL && channel >= this->NumberOfChannels )
+    {
+    this->NumberOfChannels = channel + 1;
+    this->InputChannelsModified = true;
     }
   vtkNew<vtkIntArray> events;
   events->InsertNextValue( vtkCommand::ModifiedEvent );
-  this->SetAndObserveNodeReferenceID( FILTERED_TRANSFORM_ROLE, filteredNodeId, events.GetPointer() );
+  this->SetAndObserveNodeReferenceID( role, filteredNodeId, events.GetPointer() );
+}
+
+//-----------------------------------------------------------------------------
+int vtkMRMLTransformSmootherNode
+::AddChannel( const char* inputNodeId, const char* filteredNodeId )
+{
+  const int channel = this->GetNumberOfChannels();
+  this->NumberOfChannels = channel + 1;
+  this->InputChannelsModified = true;
+  this->SetAndObserveNthInputTransformNodeID( channel, inputNodeId );
+  this->SetAndObserveNthFilteredTransformNodeID( channel, filteredNodeId );
+  this->Modified();
+  return channel;
 }
 
 //-----------------------------------------------------------------------------
 void vtkMRMLTransformSmootherNode
-::ProcessMRMLEvents( vtkObject *caller, unsigned long event, void* callData )
+::RemoveChannel( int channel )
 {
-  Superclass::ProcessMRMLEvents( caller, event, callData );
+  const int numberOfChannels = this->GetNumberOfChannels();
+  if ( channel < 0 || channel >= numberOfChannels )
+    {
+    return;
+    }
+  // Move the following channels down, as pairs
+  for (int i = channel; i < numberOfChannels - 1; ++i)
+    {
+    this->SetAndObserveNthInputTransformNodeID( i, this->GetNodeReferenceID( this->GetInputTransformRole( i + 1 ) ) );
+    this->SetAndObserveNthFilteredTransformNodeID( i, this->GetNodeReferenceID( this->GetFilteredTransformRole( i + 1 ) ) );
+    }
+  this->NumberOfChannels = numberOfChannels - 1;
+  this->InputChannelsModified = true;
+  this->SetAndObserveNodeReferenceID( this->GetInputTransformRole( numberOfChannels - 1 ), NULL );
+  this->SetAndObserveNodeReferenceID( this->GetFilteredTransformRole( numberOfChannels - 1 ), NULL );
+  this->Modified();
 }
@@ -26,8 +26,15 @@
 #include "vtkObjectFactory.h"
 
 // TransformSmoother includes
+#include "vtkSlicerTransformSmootherFilterBank.h"
+#include "vtkSlicerTransformSmootherStatistics.h"
 #include "vtkSlicerTransformSmootherModuleMRMLExport.h"
 
+// STD includes
+#include <string>
+#include <utility>
+#include <vector>
+
 class vtkMRMLLinearTransformNode;
 
 class
@@ -39,6 +46,62 @@ public:
 
   vtkTypeMacro( vtkMRMLTransformSmootherNode, vtkMRMLNode);
 
+  enum
+    {
+    // Invoked when an observed input transform node is modified, i.e. when a new sample is available.
+    // The call data is a pointer to the channel (int) of the input transform node.
+    InputDataModifiedEvent = 21001
+    };
+
+  /// Filter applied to the input transform.
+  ///  - LowPass: first-order low-pass filter with fixed cutoff frequency (CutOffFrequency).
+  ///  - OneEuro: first-order low-pass filter whose cutoff frequency increases with the
+  ///    estimated speed of the input: cutoff = MinCutOffFrequency + Beta * speed
+  ///    (G. Casiez et al., 1 Euro Filter, CHI 2012). Jitter is strongly suppressed at rest
+  ///    and lag is small during fast motions. Rotation and translation use separate cutoffs:
+  ///    speed is the translation speed (in mm/s) for translation and the angular speed
+  ///    (in deg/s, estimated in the tangent space of the rotation quaternion) for rotation.
+  ///  - Butterworth: Butterworth low-pass filter of order FilterOrder (2 or 4) with cutoff
+  ///    frequency CutOffFrequency (in Hz), as cascaded biquads. Roll-off is 40 or 80 dB/decade
+  ///    instead of 20 dB/decade, so that jitter is rejected with a higher cutoff, i.e. less lag.
+  ///    Translations are filtered directly and rotations in the tangent space (log map) of the
+  ///    current filtered rotation. Coefficients are designed for the estimated sample rate
+  ///    of the input and updated when it or the filter parameters change.
+  ///  - Kalman: constant-velocity Kalman filter of each translation and rotation coordinate
+  ///    (rotations in the tangent space of the filtered rotation), estimating velocity and
+  ///    angular velocity. The output is extrapolated by PredictionTime to compensate the latency
+  ///    of the tracking, filtering and rendering pipeline. ProcessNoise is the standard deviation
+  ///    of the acceleration (mm/s^2, deg/s^2 for rotation) and MeasurementNoise the standard deviation
+  ///    of the input noise (mm, deg for rotation): a higher ratio follows the input more closely.
+  enum FilterModeType
+    {
+    FilterLowPass = vtkSlicerTransformSmootherFilterBank::FilterLowPass,
+    FilterOneEuro = vtkSlicerTransformSmootherFilterBank::FilterOneEuro,
+    FilterButterworth = vtkSlicerTransformSmootherFilterBank::FilterButterworth,
+    FilterKalman = vtkSlicerTransformSmootherFilterBank::FilterKalman,
+    FilterMode_Last = vtkSlicerTransformSmootherFilterBank::FilterMode_Last // must be last
+    };
+
+  /// Interpolation of rotations used by the filter.
+  /// Measured on 4096 quaternion pairs (x86-64, AVX build), angular error relative to
+  /// exact slerp and throughput relative to exact slerp (~60 ns per pair):
+  ///
+  ///   Mode              max error (rotation step up to 10 deg / 90 deg / 180 deg)  speedup
+  ///   Slerp             0 (reference)                                                1x
+  ///   PolynomialSlerp   3e-14 deg / 7e-14 deg / 1.5e-6 deg                           3.5x (SSE2: 1.8x)
+  ///   Nlerp             1.2e-3 deg / 0.9 deg / 8 deg                                 13x
+  ///
+  /// Nlerp error grows with the cube of the rotation step (1.2e-6 deg for 1 deg steps),
+  /// so it is only suitable when successive samples are close, e.g. high cutoff frequency
+  /// or high tracking rate.
+  enum InterpolationModeType
+    {
+    InterpolationSlerp = vtkSlicerTransformSmootherFilterBank::InterpolationSlerp,
+    InterpolationPolynomialSlerp = vtkSlicerTransformSmootherFilterBank::InterpolationPolynomialSlerp,
+    InterpolationNlerp = vtkSlicerTransformSmootherFilterBank::InterpolationNlerp,
+    InterpolationMode_Last = vtkSlicerTransformSmootherFilterBank::InterpolationMode_Last // must be last
+    };
+
   // Standard MRML node methods
 
   static vtkMRMLTransformSmootherNode *New();
@@ -67,6 +130,95 @@ public:
   vtkGetMacro( FilterActivated, bool );
   vtkSetMacro( FilterActivated, bool );
   vtkBooleanMacro( FilterActivated, bool );
+
+  /// Filter applied to the input transform (see FilterModeType), LowPass by default
+  vtkGetMacro( FilterMode, int );
+  vtkSetClampMacro( FilterMode, int, 0, FilterMode_Last - 1 );
+
+  static const char* GetFilterModeAsString( int mode );
+  /// Returns -1 if name does not correspond to any mode
+  static int GetFilterModeFromString( const char* name );
+
+  /// Order of the Butterworth filter: 2 (default) or 4
+  vtkGetMacro( FilterOrder, int );
+  void SetFilterOrder( int order );
+
+  /// Cutoff frequency (in Hz) of the OneEuro filter when the input is at rest
+  vtkGetMacro( MinCutOffFrequency, double );
+  vtkSetMacro( MinCutOffFrequency, double );
+
+  /// Increase of the cutoff frequency of the OneEuro filter with the speed of the input
+  /// (in Hz per mm/s for translation and Hz per deg/s for rotation)
+  vtkGetMacro( Beta, double );
+  vtkSetMacro( Beta, double );
+
+  /// Time (in seconds) the output of the Kalman filter is predicted ahead of the last input sample
+  vtkGetMacro( PredictionTime, double );
+  vtkSetMacro( PredictionTime, double );
+
+  /// Standard deviation of the acceleration (mm/s^2, deg/s^2) in the Kalman filter motion model
+  vtkGetMacro( ProcessNoise, double );
+  vtkSetMacro( ProcessNoise, double );
+
+  /// Standard deviation of the noise (mm, deg) of the input of the Kalman filter
+  vtkGetMacro( MeasurementNoise, double );
+  vtkSetMacro( MeasurementNoise, double );
+
+  /// Interpolation of rotations (see InterpolationModeType), PolynomialSlerp by default
+  vtkGetMacro( InterpolationMode, int );
+  vtkSetClampMacro( InterpolationMode, int, 0, InterpolationMode_Last - 1 );
+
+  static const char* GetInterpolationModeAsString( int mode );
+  /// Returns -1 if name does not correspond to any mode
+  static int GetInterpolationModeFromString( const char* name );
+
+  /// Rate (in Hz) at which the filtered transform is written while the filter is activated,
+  /// 0 (default) to write it after each input sample. Every input sample is still filtered,
+  /// only the output is resampled: it is interpolated between the filtered poses of the two input
+  /// samples around each output time, so that e.g. a 400 Hz tracker drives a 60 Hz display with
+  /// one transform update per frame. Output times are 1/OutputRate apart; an output time without
+  /// a new input sample is skipped.
+  vtkGetMacro( OutputRate, double );
+  vtkSetClampMacro( OutputRate, double, 0.0, VTK_DOUBLE_MAX );
+
+  /// Deadband of the filtered transform: a new output is not written while it differs from the
+  /// last written one by at most OutputTranslationDeadband (in mm) and OutputRotationDeadband
+  /// (in degrees), so that observers of the filtered transform (models, slice views, rendering)
+  /// are not updated by changes below the tracking noise, e.g. when the tool is at rest.
+  /// The written transform may then differ from the filtered one by up to the deadband.
+  /// Both are 0 by default, every output is written.
+  vtkGetMacro( OutputTranslationDeadband, double );
+  vtkSetClampMacro( OutputTranslationDeadband, double, 0.0, VTK_DOUBLE_MAX );
+  vtkGetMacro( OutputRotationDeadband, double );
+  vtkSetClampMacro( OutputRotationDeadband, double, 0.0, 180.0 );
+
+  /// Weight of the filtered transforms of this node when several module nodes write the same
+  /// filtered transform node, e.g. redundant sensors of one tool: the logic then writes the weighted
+  /// average of their latest filtered transforms (see vtkSlicerTransformSmootherFilterBank::GetAveragePose).
+  /// The average is written once per tick, also when filtering is driven by the modified events of the
+  /// input transforms (see vtkSlicerTransformSmootherLogic::FilterChannel).
+  /// 1 by default; 0 excludes the node from the average.
+  vtkGetMacro( FusionWeight, double );
+  vtkSetClampMacro( FusionWeight, double, 0.0, VTK_DOUBLE_MAX );
+
+  /// Number of latest filtered poses kept by the logic, so that the filtered transform can be
+  /// queried at a past time (see vtkSlicerTransformSmootherLogic::GetTransformAtTime).
+  /// 0 (default) keeps no history. Changing it discards the history.
+  vtkGetMacro( PoseHistoryLength, int );
+  vtkSetClampMacro( PoseHistoryLength, int, 0, VTK_INT_MAX );
+
+  /// Collect execution statistics of the filter (see GetStatistics), off by default.
+  /// When off the filtering is not timed at all.
+  vtkGetMacro( StatisticsEnabled, bool );
+  vtkSetMacro( StatisticsEnabled, bool );
+  vtkBooleanMacro( StatisticsEnabled, bool );
+
+  /// Execution statistics of the filter, updated by the logic (Filter, FilterAll) while StatisticsEnabled is on:
+  /// number of processed and dropped samples, filter time and input-to-output latency percentiles.
+  /// Updating statistics does not invoke ModifiedEvent, they are meant to be polled.
+  const vtkSlicerTransformSmootherStatistics& GetStatistics() const { return this->Statistics; }
+  vtkSlicerTransformSmootherStatistics& GetStatistics() { return this->Statistics; }
+  void ResetStatistics();
   
   vtkMRMLLinearTransformNode* GetInputTransformNode();
   void SetAndObserveInputTransformNodeID( const char* inputNodeId );
@@ -74,12 +226,69 @@ public:
   vtkMRMLLinearTransformNode* GetFilteredTransformNode();
   void SetAndObserveFilteredTransformNodeID( const char* filteredNodeId );  
 
+  /// Channels are the pairs of input and filtered transforms of the node. All channels share
+  /// the filter parameters and the logic filters them together, as consecutive filters, so that
+  /// many tracked tools (e.g. 50+ sensors) only need one module node, observed once.
+  /// Channel 0 is the pair of GetInputTransformNode and GetFilteredTransformNode. Each channel has
+  /// its own pair of single-valued reference roles (see GetInputTransformRole), so clearing a transform
+  /// of a channel (setting a NULL ID) leaves an empty slot and does not affect the other channels.
+  /// Adding or removing channels restarts the filters of all channels of the node.
+  int GetNumberOfChannels();
+  vtkMRMLLinearTransformNode* GetNthInputTransformNode( int channel );
+  void SetAndObserveNthInputTransformNodeID( int channel, const char* inputNodeId );
+  vtkMRMLLinearTransformNode* GetNthFilteredTransformNode( int channel );
+  void SetAndObserveNthFilteredTransformNodeID( int channel, const char* filteredNodeId );
+  /// Add a channel filtering inputNodeId to filteredNodeId and return its index
+  int AddChannel( const char* inputNodeId, const char* filteredNodeId );
+  /// Remove a channel, the following channels are moved down by one
+  void RemoveChannel( int channel );
+  /// Node reference roles of the input and filtered transforms of a channel
+  const char* GetInputTransformRole( int channel );
+  const char* GetFilteredTransformRole( int channel );
+
   void ProcessMRMLEvents( vtkObject *caller, unsigned long event, void *callData );
 
+protected:
+
+  /// The channels of the observed input transform nodes are updated when references change
+  virtual void OnNodeReferenceAdded( vtkMRMLNodeReference* reference );
+  virtual void OnNodeReferenceModified( vtkMRMLNodeReference* reference );
+  virtual void OnNodeReferenceRemoved( vtkMRMLNodeReference* reference );
+
 private:
   
   double CutOffFrequency;
   bool FilterActivated;
+  int FilterMode;
+  int FilterOrder;
+  double MinCutOffFrequency;
+  double Beta;
+  double PredictionTime;
+  double ProcessNoise;
+  double MeasurementNoise;
+  int InterpolationMode;
+  double OutputRate;
+  double OutputTranslationDeadband;
+  double OutputRotationDeadband;
+  double FusionWeight;
+  int PoseHistoryLength;
+  bool StatisticsEnabled;
+  int NumberOfChannels;
+
+  // Reference roles of the channels, registered when a channel is first used
+  std::vector< std::string > InputTransformRoles;
+  std::vector< std::string > FilteredTransformRoles;
+  void AddChannelRoles( int numberOfChannels );
+
+  // Observed input transform nodes and their channel, sorted by node, so that the channel of an
+  // input modified event is found without reference lookups. Updated on the next event after
+  // references or channels change, and until all input references are resolved.
+  typedef std::pair< vtkObject*, int > InputChannelType;
+  std::vector< InputChannelType > InputChannels;
+  bool InputChannelsModified;
+  void UpdateInputChannels();
+
+  vtkSlicerTransformSmootherStatistics Statistics;
 
 };
 
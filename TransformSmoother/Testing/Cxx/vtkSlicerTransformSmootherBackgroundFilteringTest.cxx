@@ -0,0 +1,122 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Simulated tracker sample: rotation around the z axis plus a translation, with some jitter
+void SetSampleMatrix(vtkMatrix4x4* matrix, int sampleIndex)
+{
+  const double angle = 0.01 * sampleIndex + 0.002 * ( sampleIndex % 3 );
+  matrix->Identity();
+  matrix->SetElement( 0, 0, cos( angle ) );
+  matrix->SetElement( 0, 1, -sin( angle ) );
+  matrix->SetElement( 1, 0, sin( angle ) );
+  matrix->SetElement( 1, 1, cos( angle ) );
+  matrix->SetElement( 0, 3, 10.0 + 0.1 * sampleIndex );
+  matrix->SetElement( 1, 3, -5.0 + 0.05 * ( sampleIndex % 7 ) );
+}
+
+//-----------------------------------------------------------------------------
+// Filter a sequence of samples, changing the filter mode half-way, and return the last filtered transform
+void FilterSamples(bool background, int filterMode, vtkMatrix4x4* filteredMatrix)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+  logic->SetBackgroundFiltering( background );
+
+  vtkNew<vtkMRMLLinearTransformNode> inputNode;
+  scene->AddNode( inputNode.GetPointer() );
+  vtkNew<vtkMRMLLinearTransformNode> outputNode;
+  scene->AddNode( outputNode.GetPointer() );
+
+  vtkNew<vtkMRMLTransformSmootherNode> tsNode;
+  scene->AddNode( tsNode.GetPointer() );
+  tsNode->SetAndObserveInputTransformNodeID( inputNode->GetID() );
+  tsNode->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+  tsNode->SetCutOffFrequency( 5.0 );
+  tsNode->FilterActivatedOn();
+
+  // Samples are filtered with explicit timestamps, not when the input node is modified
+  inputNode->SetDisableModifiedEvent( 1 );
+
+  vtkNew<vtkMatrix4x4> inputMatrix;
+  const double samplingPeriod = 0.004;
+  const int numberOfSamples = 500;
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    if ( i == numberOfSamples / 2 )
+      {
+      tsNode->SetFilterMode( filterMode );
+      }
+    SetSampleMatrix( inputMatrix.GetPointer(), i );
+    inputNode->SetMatrixTransformToParent( inputMatrix.GetPointer() );
+    logic->Filter( tsNode.GetPointer(), i * samplingPeriod );
+    }
+
+  // Disabling background filtering processes and publishes all queued samples
+  logic->SetBackgroundFiltering( false );
+  outputNode->GetMatrixTransformToParent( filteredMatrix );
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherBackgroundFilteringTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  for (int filterMode = 0; filterMode < vtkMRMLTransformSmootherNode::FilterMode_Last; ++filterMode)
+    {
+    vtkNew<vtkMatrix4x4> foregroundMatrix;
+    vtkNew<vtkMatrix4x4> backgroundMatrix;
+    FilterSamples( false, filterMode, foregroundMatrix.GetPointer() );
+    FilterSamples( true, filterMode, backgroundMatrix.GetPointer() );
+
+    // Background filtering must give the same results
+    for (int row = 0; row < 3; ++row)
+      {
+      for (int column = 0; column < 4; ++column)
+        {
+        const double difference = backgroundMatrix->GetElement( row, column ) - foregroundMatrix->GetElement( row, column );
+        if ( fabs( difference ) > 1e-9 )
+          {
+          std::cerr << "Line " << __LINE__ << ": " << vtkMRMLTransformSmootherNode::GetFilterModeAsString( filterMode )
+                    << " filter: background and foreground filtered transforms differ by " << difference
+                    << " at (" << row << ", " << column << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherBatchKernels.h"
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+typedef void (*InterpolationKernelType)(int, const double*,
+  const double*, const double*, const double*, const double*,
+  const double*, const double*, const double*, const double*,
+  double*, double*, double*, double*);
+
+//-----------------------------------------------------------------------------
+// Deterministic uniform random number in [-1, 1]
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return static_cast<double>( ( seed >> 8 ) & 0xFFFFFF ) / static_cast<double>( 0xFFFFFF ) * 2.0 - 1.0;
+}
+
+//-----------------------------------------------------------------------------
+void Normalize(double q[4])
+{
+  const double norm = sqrt( q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3] );
+  for (int i = 0; i < 4; ++i)
+    {
+    q[i] /= norm;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Compare a batch kernel with the scalar Slerp of the logic for quaternion pairs
+// separated by rotations up to maxAngle (in radians).
+bool TestBatchSlerp(InterpolationKernelType kernel, const char* kernelName,
+                    int count, double maxAngle, double tolerance, bool inPlace, unsigned int seed)
+{
+  std::vector<double> t( count );
+  std::vector<double> from[4];
+  std::vector<double> to[4];
+  std::vector<double> result[4];
+  for (int c = 0; c < 4; ++c)
+    {
+    from[c].resize( count );
+    to[c].resize( count );
+    result[c].resize( count );
+    }
+
+  for (int i = 0; i < count; ++i)
+    {
+    double p[4] = { Random( seed ), Random( seed ), Random( seed ), Random( seed ) };
+    Normalize( p );
+    // Rotate p by a random rotation of angle up to maxAngle
+    double axis[3] = { Random( seed ), Random( seed ), Random( seed ) };
+    const double axisNorm = sqrt( axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2] );
+    const double halfAngle = 0.5 * maxAngle * fabs( Random( seed ) );
+    const double d[4] = { cos( halfAngle ), sin( halfAngle ) * axis[0] / axisNorm,
+                          sin( halfAngle ) * axis[1] / axisNorm, sin( halfAngle ) * axis[2] / axisNorm };
+    double q[4] = { p[0]*d[0] - p[1]*d[1] - p[2]*d[2] - p[3]*d[3],
+                    p[0]*d[1] + p[1]*d[0] + p[2]*d[3] - p[3]*d[2],
+                    p[0]*d[2] - p[1]*d[3] + p[2]*d[0] + p[3]*d[1],
+                    p[0]*d[3] + p[1]*d[2] - p[2]*d[1] + p[3]*d[0] };
+    if ( i % 2 )
+      {
+      // Same rotation with opposite sign, exercises the shortest path sign adjustment
+      for (int c = 0; c < 4; ++c)
+        {
+        q[c] = -q[c];
+        }
+      }
+    for (int c = 0; c < 4; ++c)
+      {
+      from[c][i] = p[c];
+      to[c][i] = q[c];
+      }
+    t[i] = 0.5 * ( Random( seed ) + 1.0 );
+    }
+
+  std::vector<double>* output = inPlace ? from : result;
+  std::vector<double> reference[4] = { from[0], from[1], from[2], from[3] };
+  kernel( count, &t[0],
+    &from[0][0], &from[1][0], &from[2][0], &from[3][0],
+    &to[0][0], &to[1][0], &to[2][0], &to[3][0],
+    &output[0][0], &output[1][0], &output[2][0], &output[3][0] );
+
+  for (int i = 0; i < count; ++i)
+    {
+    double p[4] = { reference[0][i], reference[1][i], reference[2][i], reference[3][i] };
+    double q[4] = { to[0][i], to[1][i], to[2][i], to[3][i] };
+    double expected[4] = { 0.0, 0.0, 0.0, 0.0 };
+    vtkSlicerTransformSmootherLogic::Slerp( expected, t[i], p, q );
+    // Scalar Slerp switches to an unnormalized linear interpolation for nearby quaternions
+    Normalize( expected );
+    for (int c = 0; c < 4; ++c)
+      {
+      if ( fabs( expected[c] - output[c][i] ) > tolerance )
+        {
+        std::cerr << "Batch " << kernelName << " (" << vtkSlicerTransformSmootherBatchKernels::GetInstructionSet()
+                  << ") mismatch for pair " << i << " of " << count << ", max angle " << maxAngle
+                  << ", component " << c << ": expected " << expected[c] << ", got " << output[c][i] << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherBatchSlerpTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const double pi = 3.14159265358979323846;
+  // The scalar Slerp uses a linear interpolation when quaternions are closer than 1e-4
+  // (in cosine), which bounds the achievable agreement to a few 1e-8.
+  const double tolerance = 1e-7;
+  bool success = true;
+
+  const int numberOfKernels = 2;
+  InterpolationKernelType kernels[numberOfKernels] =
+    { vtkSlicerTransformSmootherBatchKernels::Slerp, vtkSlicerTransformSmootherBatchKernels::PolynomialSlerp };
+  const char* kernelNames[numberOfKernels] = { "Slerp", "PolynomialSlerp" };
+  for (int k = 0; k < numberOfKernels; ++k)
+    {
+    // Odd counts exercise the scalar remainder of the vectorized loop
+    success &= TestBatchSlerp( kernels[k], kernelNames[k], 1, 0.1, tolerance, false, 1 );
+    success &= TestBatchSlerp( kernels[k], kernelNames[k], 7, 0.1, tolerance, true, 2 );
+    // Per-sample steps of a low-pass filter (up to a few degrees)
+    success &= TestBatchSlerp( kernels[k], kernelNames[k], 1001, 0.1, tolerance, false, 3 );
+    success &= TestBatchSlerp( kernels[k], kernelNames[k], 1001, 0.1, tolerance, true, 4 );
+    // Large rotations, up to half a turn
+    success &= TestBatchSlerp( kernels[k], kernelNames[k], 1003, pi / 3.0, tolerance, false, 5 );
+    success &= TestBatchSlerp( kernels[k], kernelNames[k], 1003, pi, tolerance, false, 6 );
+    }
+
+  // Normalized linear interpolation is only close to slerp for small rotations
+  success &= TestBatchSlerp( vtkSlicerTransformSmootherBatchKernels::Nlerp, "Nlerp", 1001, 0.1, 1e-5, false, 7 );
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
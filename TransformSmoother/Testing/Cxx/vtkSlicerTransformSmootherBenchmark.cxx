@@ -0,0 +1,420 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Benchmark of the transform smoothing pipeline, from the interpolation kernels
+// to the whole update of a scene with many module nodes.
+//
+// Usage: vtkSlicerTransformSmootherBenchmark [--iterations N] [--output results.json]
+//
+// Results are written as JSON (to standard output if no output file is given):
+// time per operation, per node for scene ticks, and the number of nodes that can be
+// smoothed within the frame time of a 60 Hz display.
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherBatchKernels.h"
+#include "vtkSlicerTransformSmootherLogic.h"
+#include "vtkMRMLTransformSmootherNode.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Gives access to the protected interpolation of the logic
+class vtkSlicerTransformSmootherBenchmarkLogic : public vtkSlicerTransformSmootherLogic
+{
+public:
+  static vtkSlicerTransformSmootherBenchmarkLogic* New();
+  vtkTypeMacro(vtkSlicerTransformSmootherBenchmarkLogic, vtkSlicerTransformSmootherLogic);
+
+  void InterpolateTransform(vtkMatrix4x4* itemAmatrix, vtkMatrix4x4* itemBmatrix,
+                            double itemAweight, double itemBweight, vtkMatrix4x4* interpolatedMatrix)
+  {
+    this->GetInterpolatedTransform( itemAmatrix, itemBmatrix, itemAweight, itemBweight, interpolatedMatrix );
+  }
+
+protected:
+  vtkSlicerTransformSmootherBenchmarkLogic() {}
+  virtual ~vtkSlicerTransformSmootherBenchmarkLogic() {}
+
+private:
+  vtkSlicerTransformSmootherBenchmarkLogic(const vtkSlicerTransformSmootherBenchmarkLogic&); // Not implemented
+  void operator=(const vtkSlicerTransformSmootherBenchmarkLogic&); // Not implemented
+};
+
+vtkStandardNewMacro(vtkSlicerTransformSmootherBenchmarkLogic);
+
+//-----------------------------------------------------------------------------
+namespace
+{
+
+const double SamplingPeriod = 0.004; // 250 Hz tracker
+const double FrameTime = 1.0 / 60.0; // 60 Hz display
+
+struct BenchmarkResult
+{
+  std::string Name;
+  int NumberOfNodes;
+  int Iterations;
+  double SecondsPerIteration;
+};
+
+//-----------------------------------------------------------------------------
+// Simulated tracker sample of a tool: rotation around an oblique axis plus a translation, with some jitter
+void SetSampleMatrix(vtkMatrix4x4* matrix, int sampleIndex, int toolIndex)
+{
+  const double angle = 0.01 * sampleIndex + 0.002 * ( ( sampleIndex + toolIndex ) % 3 ) + 0.1 * toolIndex;
+  const double c = cos( angle );
+  const double s = sin( angle );
+  matrix->Identity();
+  matrix->SetElement( 0, 0, c );
+  matrix->SetElement( 0, 2, s );
+  matrix->SetElement( 2, 0, -s );
+  matrix->SetElement( 2, 2, c );
+  matrix->SetElement( 0, 3, 10.0 * toolIndex + 0.1 * sampleIndex );
+  matrix->SetElement( 1, 3, -5.0 + 0.05 * ( sampleIndex % 7 ) );
+  matrix->SetElement( 2, 3, 100.0 );
+}
+
+//-----------------------------------------------------------------------------
+void RandomQuaternion(double q[4])
+{
+  double norm = 0.0;
+  for (int i = 0; i < 4; i++)
+    {
+    q[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    norm += q[i] * q[i];
+    }
+  norm = sqrt( norm );
+  for (int i = 0; i < 4; i++)
+    {
+    q[i] /= norm;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Scene with a number of module nodes, each smoothing its own input transform
+class BenchmarkScene
+{
+public:
+  BenchmarkScene(vtkSlicerTransformSmootherLogic* logic, int numberOfNodes, int filterMode)
+  {
+    this->Logic = logic;
+    logic->SetMRMLScene( this->Scene.GetPointer() );
+    for (int i = 0; i < numberOfNodes; ++i)
+      {
+      vtkSmartPointer<vtkMRMLLinearTransformNode> inputNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
+      this->Scene->AddNode( inputNode );
+      vtkSmartPointer<vtkMRMLLinearTransformNode> outputNode = vtkSmartPointer<vtkMRMLLinearTransformNode>::New();
+      this->Scene->AddNode( outputNode );
+      vtkSmartPointer<vtkMRMLTransformSmootherNode> tsNode = vtkSmartPointer<vtkMRMLTransformSmootherNode>::New();
+      this->Scene->AddNode( tsNode );
+      tsNode->SetAndObserveInputTransformNodeID( inputNode->GetID() );
+      tsNode->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+      tsNode->SetFilterMode( filterMode );
+      tsNode->FilterActivatedOn();
+      this->InputNodes.push_back( inputNode );
+      this->ModuleNodes.push_back( tsNode );
+      }
+  }
+
+  ~BenchmarkScene()
+  {
+    this->Logic->SetMRMLScene( NULL );
+  }
+
+  /// Set new input samples of all tools. If notify is false the input nodes
+  /// do not invoke modified events, so that filters are not triggered.
+  void SetInputs(int sampleIndex, bool notify)
+  {
+    for (size_t i = 0; i < this->InputNodes.size(); ++i)
+      {
+      SetSampleMatrix( this->Matrix.GetPointer(), sampleIndex, static_cast<int>( i ) );
+      vtkMRMLLinearTransformNode* inputNode = this->InputNodes[i];
+      if ( notify )
+        {
+        inputNode->SetMatrixTransformToParent( this->Matrix.GetPointer() );
+        }
+      else
+        {
+        int wasDisabled = inputNode->GetDisableModifiedEvent();
+        inputNode->SetDisableModifiedEvent( 1 );
+        inputNode->SetMatrixTransformToParent( this->Matrix.GetPointer() );
+        inputNode->SetDisableModifiedEvent( wasDisabled );
+        }
+      }
+  }
+
+  vtkSlicerTransformSmootherLogic* Logic;
+  vtkNew<vtkMRMLScene> Scene;
+  vtkNew<vtkMatrix4x4> Matrix;
+  std::vector< vtkSmartPointer<vtkMRMLLinearTransformNode> > InputNodes;
+  std::vector< vtkSmartPointer<vtkMRMLTransformSmootherNode> > ModuleNodes;
+};
+
+//-----------------------------------------------------------------------------
+BenchmarkResult MakeResult(const std::string& name, int numberOfNodes, int iterations, double seconds)
+{
+  BenchmarkResult result;
+  result.Name = name;
+  result.NumberOfNodes = numberOfNodes;
+  result.Iterations = iterations;
+  result.SecondsPerIteration = seconds / iterations;
+  std::cerr << name << " (" << numberOfNodes << " nodes): "
+            << result.SecondsPerIteration * 1e9 << " ns" << std::endl;
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkSlerp(int iterations, std::vector<BenchmarkResult>& results)
+{
+  const int numberOfPairs = 1024;
+  std::vector<double> from( 4 * numberOfPairs );
+  std::vector<double> to( 4 * numberOfPairs );
+  std::vector<double> t( numberOfPairs );
+  for (int i = 0; i < numberOfPairs; ++i)
+    {
+    RandomQuaternion( &from[4 * i] );
+    RandomQuaternion( &to[4 * i] );
+    t[i] = static_cast<double>( rand() ) / RAND_MAX;
+    }
+
+  double result[4] = { 0.0, 0.0, 0.0, 0.0 };
+  double checksum = 0.0;
+  double start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+  for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+    for (int i = 0; i < numberOfPairs; ++i)
+      {
+      vtkSlicerTransformSmootherLogic::Slerp( result, t[i], &from[4 * i], &to[4 * i] );
+      checksum += result[0];
+      }
+    }
+  double seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+  results.push_back( MakeResult( "Slerp", 1, iterations * numberOfPairs, seconds ) );
+
+  // Batch kernels on the same quaternion pairs, stored as structure of arrays
+  std::vector<double> fromW( numberOfPairs ), fromX( numberOfPairs ), fromY( numberOfPairs ), fromZ( numberOfPairs );
+  std::vector<double> toW( numberOfPairs ), toX( numberOfPairs ), toY( numberOfPairs ), toZ( numberOfPairs );
+  std::vector<double> resultW( numberOfPairs ), resultX( numberOfPairs ), resultY( numberOfPairs ), resultZ( numberOfPairs );
+  for (int i = 0; i < numberOfPairs; ++i)
+    {
+    fromW[i] = from[4 * i]; fromX[i] = from[4 * i + 1]; fromY[i] = from[4 * i + 2]; fromZ[i] = from[4 * i + 3];
+    toW[i] = to[4 * i]; toX[i] = to[4 * i + 1]; toY[i] = to[4 * i + 2]; toZ[i] = to[4 * i + 3];
+    }
+  const char* kernelNames[3] = { "BatchSlerp", "BatchPolynomialSlerp", "BatchNlerp" };
+  vtkSlicerTransformSmootherBatchKernels::RotationInterpolationFunction kernels[3] =
+    {
+    vtkSlicerTransformSmootherBatchKernels::Slerp,
+    vtkSlicerTransformSmootherBatchKernels::PolynomialSlerp,
+    vtkSlicerTransformSmootherBatchKernels::Nlerp
+    };
+  for (int k = 0; k < 3; ++k)
+    {
+    start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+    for (int iteration = 0; iteration < iterations; ++iteration)
+      {
+      kernels[k]( numberOfPairs, &t[0], &fromW[0], &fromX[0], &fromY[0], &fromZ[0],
+                  &toW[0], &toX[0], &toY[0], &toZ[0], &resultW[0], &resultX[0], &resultY[0], &resultZ[0] );
+      checksum += resultW[iteration % numberOfPairs];
+      }
+    seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+    results.push_back( MakeResult( kernelNames[k], 1, iterations * numberOfPairs, seconds ) );
+    }
+
+  // Keep the compiler from optimizing the computations away
+  if ( checksum == 12345.6789 )
+    {
+    std::cerr << checksum << std::endl;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkGetInterpolatedTransform(int iterations, std::vector<BenchmarkResult>& results)
+{
+  vtkNew<vtkSlicerTransformSmootherBenchmarkLogic> logic;
+  vtkNew<vtkMatrix4x4> matrixA;
+  vtkNew<vtkMatrix4x4> matrixB;
+  vtkNew<vtkMatrix4x4> interpolatedMatrix;
+  SetSampleMatrix( matrixA.GetPointer(), 0, 0 );
+  SetSampleMatrix( matrixB.GetPointer(), 10, 0 );
+
+  const double start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+  for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+    logic->InterpolateTransform( matrixA.GetPointer(), matrixB.GetPointer(), 1.0, 0.1,
+                                 interpolatedMatrix.GetPointer() );
+    }
+  const double seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+  results.push_back( MakeResult( "GetInterpolatedTransform", 1, iterations, seconds ) );
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkFilter(int iterations, std::vector<BenchmarkResult>& results)
+{
+  for (int filterMode = 0; filterMode < vtkMRMLTransformSmootherNode::FilterMode_Last; ++filterMode)
+    {
+    const std::string modeName = vtkMRMLTransformSmootherNode::GetFilterModeAsString( filterMode );
+    vtkNew<vtkSlicerTransformSmootherLogic> logic;
+    BenchmarkScene scene( logic.GetPointer(), 1, filterMode );
+    vtkMRMLTransformSmootherNode* tsNode = scene.ModuleNodes[0];
+    vtkNew<vtkMatrix4x4> inputMatrix;
+    vtkNew<vtkMatrix4x4> outputMatrix;
+
+    // Filter computation only, without scene update
+    int sampleIndex = 0;
+    double start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+    for (int iteration = 0; iteration < iterations; ++iteration, ++sampleIndex)
+      {
+      SetSampleMatrix( inputMatrix.GetPointer(), sampleIndex, 0 );
+      logic->ProcessSample( tsNode, inputMatrix.GetPointer(), sampleIndex * SamplingPeriod, outputMatrix.GetPointer() );
+      }
+    double seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+    results.push_back( MakeResult( "ProcessSample/" + modeName, 1, iterations, seconds ) );
+
+    // Filter of a module node: reads the input transform node and writes the output transform node
+    start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+    for (int iteration = 0; iteration < iterations; ++iteration, ++sampleIndex)
+      {
+      scene.SetInputs( sampleIndex, false );
+      logic->Filter( tsNode, sampleIndex * SamplingPeriod );
+      }
+    seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+    results.push_back( MakeResult( "Filter/" + modeName, 1, iterations, seconds ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkTick(int iterations, std::vector<BenchmarkResult>& results)
+{
+  // Large scenes show the scaling of the parallel FilterAll update
+  const int numberOfNodesList[5] = { 1, 10, 100, 1000, 5000 };
+  for (int n = 0; n < 5; ++n)
+    {
+    const int numberOfNodes = numberOfNodesList[n];
+    // Keep the total amount of work similar for all scene sizes
+    const int tickIterations = std::max( 10, iterations / numberOfNodes );
+    vtkNew<vtkSlicerTransformSmootherLogic> logic;
+    BenchmarkScene scene( logic.GetPointer(), numberOfNodes, vtkMRMLTransformSmootherNode::FilterLowPass );
+
+    // Tracker updates all input transforms, each modification triggers the filter of its module node
+    int sampleIndex = 0;
+    double start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+    for (int iteration = 0; iteration < tickIterations; ++iteration, ++sampleIndex)
+      {
+      scene.SetInputs( sampleIndex, true );
+      }
+    double seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+    results.push_back( MakeResult( "Tick/InputModified", numberOfNodes, tickIterations, seconds ) );
+
+    // Tracker updates all input transforms silently, then all filters are updated in a single pass
+    start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+    for (int iteration = 0; iteration < tickIterations; ++iteration, ++sampleIndex)
+      {
+      scene.SetInputs( sampleIndex, false );
+      logic->FilterAll( sampleIndex * SamplingPeriod );
+      }
+    seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+    results.push_back( MakeResult( "Tick/FilterAll", numberOfNodes, tickIterations, seconds ) );
+    }
+}
+
+//-----------------------------------------------------------------------------
+void WriteResults(std::ostream& os, const std::vector<BenchmarkResult>& results)
+{
+  os << "{" << std::endl;
+  os << "  \"instructionSet\": \"" << vtkSlicerTransformSmootherBatchKernels::GetInstructionSet() << "\"," << std::endl;
+  os << "  \"frameTime\": " << FrameTime << "," << std::endl;
+  os << "  \"results\": [" << std::endl;
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+    const BenchmarkResult& result = results[i];
+    const double secondsPerNode = result.SecondsPerIteration / result.NumberOfNodes;
+    os << "    {"
+       << " \"name\": \"" << result.Name << "\","
+       << " \"nodes\": " << result.NumberOfNodes << ","
+       << " \"iterations\": " << result.Iterations << ","
+       << " \"nanosecondsPerIteration\": " << result.SecondsPerIteration * 1e9 << ","
+       << " \"nanosecondsPerNode\": " << secondsPerNode * 1e9 << ","
+       << " \"nodesPerFrame\": " << static_cast<long>( secondsPerNode > 0.0 ? FrameTime / secondsPerNode : 0.0 )
+       << " }" << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+    }
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  int iterations = 10000;
+  const char* outputFileName = NULL;
+  for (int i = 1; i < argc; ++i)
+    {
+    if ( !strcmp( argv[i], "--iterations" ) && i + 1 < argc )
+      {
+      iterations = std::max( 1, atoi( argv[++i] ) );
+      }
+    else if ( !strcmp( argv[i], "--output" ) && i + 1 < argc )
+      {
+      outputFileName = argv[++i];
+      }
+    else
+      {
+      std::cerr << "Usage: " << argv[0] << " [--iterations N] [--output results.json]" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::vector<BenchmarkResult> results;
+  BenchmarkSlerp( std::max( 1, iterations / 100 ), results );
+  BenchmarkGetInterpolatedTransform( iterations, results );
+  BenchmarkFilter( iterations, results );
+  BenchmarkTick( iterations, results );
+
+  if ( outputFileName == NULL )
+    {
+    WriteResults( std::cout, results );
+    return EXIT_SUCCESS;
+    }
+
+  std::ofstream output( outputFileName );
+  if ( !output )
+    {
+    std::cerr << "Cannot write " << outputFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  WriteResults( output, results );
+  return EXIT_SUCCESS;
+}
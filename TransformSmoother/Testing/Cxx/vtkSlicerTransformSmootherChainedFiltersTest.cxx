@@ -0,0 +1,100 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherChainedFiltersTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  // Chain of module nodes: the filtered transform of each one is the input transform of the next one.
+  // Without filter, so that all transforms of the chain are the first input transform.
+  // Filtering is driven by the modified events: writing a filtered transform filters the next module
+  // node while the output batch of the previous one is being completed.
+  const int numberOfFilters = 8;
+  std::vector< vtkSmartPointer< vtkMRMLLinearTransformNode > > transformNodes;
+  for (int i = 0; i <= numberOfFilters; ++i)
+    {
+    vtkSmartPointer< vtkMRMLLinearTransformNode > transformNode = vtkSmartPointer< vtkMRMLLinearTransformNode >::New();
+    scene->AddNode( transformNode );
+    transformNodes.push_back( transformNode );
+    }
+  std::vector< vtkSmartPointer< vtkMRMLTransformSmootherNode > > tsNodes;
+  for (int i = 0; i < numberOfFilters; ++i)
+    {
+    vtkSmartPointer< vtkMRMLTransformSmootherNode > tsNode = vtkSmartPointer< vtkMRMLTransformSmootherNode >::New();
+    scene->AddNode( tsNode );
+    tsNode->SetAndObserveInputTransformNodeID( transformNodes[i]->GetID() );
+    tsNode->SetAndObserveFilteredTransformNodeID( transformNodes[i + 1]->GetID() );
+    tsNodes.push_back( tsNode );
+    }
+
+  vtkNew<vtkMatrix4x4> inputMatrix;
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int sample = 1; sample <= 10; ++sample)
+    {
+    inputMatrix->SetElement( 0, 3, 10.0 * sample );
+    transformNodes[0]->SetMatrixTransformToParent( inputMatrix.GetPointer() );
+    for (int i = 1; i <= numberOfFilters; ++i)
+      {
+      transformNodes[i]->GetMatrixTransformToParent( matrix.GetPointer() );
+      if ( matrix->GetElement( 0, 3 ) != 10.0 * sample )
+        {
+        std::cerr << "Line " << __LINE__ << ": sample " << sample << ": transform " << i << " of the chain is "
+                  << matrix->GetElement( 0, 3 ) << ", expected " << 10.0 * sample << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Same when all module nodes are filtered in one pass (timestamped with the clock, as the events)
+  for (int sample = 11; sample <= 20; ++sample)
+    {
+    transformNodes[0]->SetDisableModifiedEvent( 1 );
+    inputMatrix->SetElement( 0, 3, 10.0 * sample );
+    transformNodes[0]->SetMatrixTransformToParent( inputMatrix.GetPointer() );
+    transformNodes[0]->SetDisableModifiedEvent( 0 );
+    logic->FilterAll();
+    transformNodes[numberOfFilters]->GetMatrixTransformToParent( matrix.GetPointer() );
+    if ( matrix->GetElement( 0, 3 ) != 10.0 * sample )
+      {
+      std::cerr << "Line " << __LINE__ << ": sample " << sample << ": end of the chain is "
+                << matrix->GetElement( 0, 3 ) << ", expected " << 10.0 * sample << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
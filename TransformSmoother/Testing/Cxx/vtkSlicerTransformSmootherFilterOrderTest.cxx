@@ -0,0 +1,96 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherFilterBank.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkSetGet.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherFilterOrderTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // 1 mm vibration at 20 Hz sampled at 400 Hz, four times the cutoff frequency:
+  // attenuated 16 times by a second order Butterworth filter and 256 times by a fourth order one
+  const double samplingPeriod = 0.0025;
+  const double vibrationFrequency = 20.0;
+  const int numberOfSamples = 2000;
+
+  // Filters: low-pass, Butterworth of order 2 and 4, and Butterworth switched from order 2 to 4
+  // half-way, which must then behave as the filter created with order 4
+  const int numberOfFilters = 4;
+  const int orders[numberOfFilters] = { 2, 2, 4, 2 };
+  vtkSlicerTransformSmootherFilterBank filters;
+  vtkSlicerTransformSmootherFilterBank::FilterParameters parameters;
+  parameters.Activated = true;
+  parameters.CutOffFrequency = 5.0;
+  for (int i = 0; i < numberOfFilters; ++i)
+    {
+    filters.AddFilter();
+    parameters.FilterMode = ( i == 0 ) ? vtkSlicerTransformSmootherFilterBank::FilterLowPass
+      : vtkSlicerTransformSmootherFilterBank::FilterButterworth;
+    parameters.FilterOrder = orders[i];
+    filters.SetFilterParameters( i, parameters );
+    }
+
+  double amplitudes[numberOfFilters] = { 0.0, 0.0, 0.0, 0.0 };
+  const double rotation[4] = { 1.0, 0.0, 0.0, 0.0 };
+  for (int sample = 0; sample < numberOfSamples; ++sample)
+    {
+    if ( sample == numberOfSamples / 2 )
+      {
+      parameters.FilterOrder = 4;
+      filters.SetFilterParameters( numberOfFilters - 1, parameters );
+      }
+    const double timestamp = sample * samplingPeriod;
+    const double translation[3] = { sin( 2.0 * vtkMath::Pi() * vibrationFrequency * timestamp ), 0.0, 0.0 };
+    for (int i = 0; i < numberOfFilters; ++i)
+      {
+      filters.SetSample( i, timestamp, rotation, translation );
+      double filteredRotation[4];
+      double filteredTranslation[3];
+      filters.GetOutputPose( i, filteredRotation, filteredTranslation );
+      // Amplitude once the filters have settled
+      if ( sample > numberOfSamples * 3 / 4 )
+        {
+        amplitudes[i] = std::max( amplitudes[i], fabs( filteredTranslation[0] ) );
+        }
+      }
+    }
+
+  // The low-pass filter has a time constant of 1/cutoff
+  const double lowPassGain = 1.0 / sqrt( 1.0 + pow( 2.0 * vtkMath::Pi() * vibrationFrequency / parameters.CutOffFrequency, 2.0 ) );
+  const double expectedAmplitudes[numberOfFilters] = { lowPassGain, 1.0 / 16.0, 1.0 / 256.0, 1.0 / 256.0 };
+  for (int i = 0; i < numberOfFilters; ++i)
+    {
+    if ( amplitudes[i] < 0.7 * expectedAmplitudes[i] || amplitudes[i] > 1.3 * expectedAmplitudes[i] )
+      {
+      std::cerr << "Line " << __LINE__ << ": filter " << i << " attenuates the vibration to " << amplitudes[i]
+                << " mm, expected " << expectedAmplitudes[i] << " mm" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
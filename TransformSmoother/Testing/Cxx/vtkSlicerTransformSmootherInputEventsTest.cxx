@@ -0,0 +1,168 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+typedef std::vector< vtkSmartPointer< vtkMRMLLinearTransformNode > > TransformNodeList;
+
+//-----------------------------------------------------------------------------
+// Channels of the input data modified events of the module node
+void OnInputDataModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid), void* clientData, void* callData)
+{
+  std::vector< int >* channels = static_cast< std::vector< int >* >( clientData );
+  channels->push_back( callData != NULL ? *static_cast< int* >( callData ) : -1 );
+}
+
+//-----------------------------------------------------------------------------
+vtkMRMLLinearTransformNode* AddTransformNode(vtkMRMLScene* scene, TransformNodeList& nodes)
+{
+  vtkSmartPointer< vtkMRMLLinearTransformNode > node = vtkSmartPointer< vtkMRMLLinearTransformNode >::New();
+  scene->AddNode( node );
+  nodes.push_back( node );
+  return node;
+}
+
+//-----------------------------------------------------------------------------
+void SetTranslation(vtkMRMLLinearTransformNode* node, double x)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement( 0, 3, x );
+  node->SetMatrixTransformToParent( matrix.GetPointer() );
+}
+
+//-----------------------------------------------------------------------------
+double GetTranslation(vtkMRMLLinearTransformNode* node)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  node->GetMatrixTransformToParent( matrix.GetPointer() );
+  return matrix->GetElement( 0, 3 );
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherInputEventsTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  // Module node with several channels, without filter so that the outputs are the inputs.
+  // Modified events of the input transform nodes are enabled: they drive the filtering.
+  const int numberOfChannels = 3;
+  TransformNodeList inputNodes;
+  TransformNodeList outputNodes;
+  vtkNew<vtkMRMLTransformSmootherNode> tsNode;
+  scene->AddNode( tsNode.GetPointer() );
+  for (int channel = 0; channel < numberOfChannels; ++channel)
+    {
+    vtkMRMLLinearTransformNode* inputNode = AddTransformNode( scene.GetPointer(), inputNodes );
+    vtkMRMLLinearTransformNode* outputNode = AddTransformNode( scene.GetPointer(), outputNodes );
+    tsNode->AddChannel( inputNode->GetID(), outputNode->GetID() );
+    }
+  tsNode->StatisticsEnabledOn();
+
+  std::vector< int > eventChannels;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback( OnInputDataModified );
+  callback->SetClientData( &eventChannels );
+  tsNode->AddObserver( vtkMRMLTransformSmootherNode::InputDataModifiedEvent, callback.GetPointer() );
+
+  // Each input modification filters the new sample of its channel only, without explicit Filter call
+  unsigned long numberOfSamples = 0;
+  for (int sample = 1; sample <= 5; ++sample)
+    {
+    for (int channel = 0; channel < numberOfChannels; ++channel)
+      {
+      eventChannels.clear();
+      const double translation = 100.0 * sample + channel;
+      SetTranslation( inputNodes[channel], translation );
+      ++numberOfSamples;
+      if ( eventChannels.size() != 1 || eventChannels[0] != channel )
+        {
+        std::cerr << "Line " << __LINE__ << ": modification of the input of channel " << channel << " invoked "
+                  << eventChannels.size() << " input data modified events, expected one for channel " << channel << std::endl;
+        return EXIT_FAILURE;
+        }
+      for (int other = 0; other < numberOfChannels; ++other)
+        {
+        const double expectedTranslation = ( other <= channel ? 100.0 * sample : 100.0 * ( sample - 1 ) ) + other;
+        if ( sample == 1 && other > channel )
+          {
+          // Not written yet
+          continue;
+          }
+        if ( GetTranslation( outputNodes[other] ) != expectedTranslation )
+          {
+          std::cerr << "Line " << __LINE__ << ": sample " << sample << ", input of channel " << channel
+                    << " modified: output of channel " << other << " is " << GetTranslation( outputNodes[other] )
+                    << ", expected " << expectedTranslation << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // Writing the filtered transforms (by the logic above, or by anyone else) does not filter again
+  eventChannels.clear();
+  SetTranslation( outputNodes[1], -1.0 );
+  if ( !eventChannels.empty() )
+    {
+    std::cerr << "Line " << __LINE__ << ": modification of a filtered transform invoked "
+              << eventChannels.size() << " input data modified events" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const vtkSlicerTransformSmootherStatistics& statistics = tsNode->GetStatistics();
+  if ( statistics.GetNumberOfProcessedSamples() + statistics.GetNumberOfDroppedSamples() != numberOfSamples )
+    {
+    std::cerr << "Line " << __LINE__ << ": " << statistics.GetNumberOfProcessedSamples() << " processed and "
+              << statistics.GetNumberOfDroppedSamples() << " dropped samples, expected "
+              << numberOfSamples << " input samples" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A channel whose input changes gets the events of its new input node only
+  vtkMRMLLinearTransformNode* newInputNode = AddTransformNode( scene.GetPointer(), inputNodes );
+  tsNode->SetAndObserveNthInputTransformNodeID( 2, newInputNode->GetID() );
+  eventChannels.clear();
+  SetTranslation( inputNodes[2], 1000.0 );
+  SetTranslation( newInputNode, 2000.0 );
+  if ( eventChannels.size() != 1 || eventChannels[0] != 2 || GetTranslation( outputNodes[2] ) != 2000.0 )
+    {
+    std::cerr << "Line " << __LINE__ << ": events of the new input node of channel 2 not routed to channel 2" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
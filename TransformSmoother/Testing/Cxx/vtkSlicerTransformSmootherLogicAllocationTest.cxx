@@ -0,0 +1,245 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+#include "vtkMRMLTransformSmootherNode.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+//-----------------------------------------------------------------------------
+// Global allocation counter. Only allocations performed while CountAllocations
+// is set are counted.
+namespace
+{
+bool CountAllocations = false;
+int NumberOfAllocations = 0;
+
+void* CountedAllocate(std::size_t size)
+{
+  if ( CountAllocations )
+    {
+    ++NumberOfAllocations;
+    }
+  void* ptr = std::malloc( size > 0 ? size : 1 );
+  if ( ptr == NULL )
+    {
+    throw std::bad_alloc();
+    }
+  return ptr;
+}
+}
+
+#if __cplusplus >= 201103L
+void* operator new(std::size_t size) { return CountedAllocate( size ); }
+void* operator new[](std::size_t size) { return CountedAllocate( size ); }
+void operator delete(void* ptr) noexcept { std::free( ptr ); }
+void operator delete[](void* ptr) noexcept { std::free( ptr ); }
+#else
+void* operator new(std::size_t size) throw(std::bad_alloc) { return CountedAllocate( size ); }
+void* operator new[](std::size_t size) throw(std::bad_alloc) { return CountedAllocate( size ); }
+void operator delete(void* ptr) throw() { std::free( ptr ); }
+void operator delete[](void* ptr) throw() { std::free( ptr ); }
+#endif
+
+//-----------------------------------------------------------------------------
+namespace
+{
+// Simulated tracker sample: rotation around an oblique axis plus a translation, with some jitter
+void SetSampleMatrix(vtkMatrix4x4* matrix, int sampleIndex)
+{
+  const double angle = 0.01 * sampleIndex + 0.002 * ( sampleIndex % 3 );
+  const double c = cos( angle );
+  const double s = sin( angle );
+  matrix->Identity();
+  matrix->SetElement( 0, 0, c );
+  matrix->SetElement( 0, 1, -s );
+  matrix->SetElement( 1, 0, s );
+  matrix->SetElement( 1, 1, c );
+  matrix->SetElement( 0, 3, 10.0 + 0.1 * sampleIndex );
+  matrix->SetElement( 1, 3, -5.0 + 0.05 * ( sampleIndex % 7 ) );
+  matrix->SetElement( 2, 3, 100.0 );
+}
+
+const double SamplingPeriod = 0.004; // 250 Hz tracker
+
+//-----------------------------------------------------------------------------
+// Ways of filtering a sample: directly, or from the input transform node to the filtered transform node,
+// by explicit calls or by the modified event of the input transform node, as in the module
+enum
+{
+  Tick_ProcessSample = 0,
+  Tick_FilterChannel,
+  Tick_FilterAll,
+  Tick_InputEvent,
+  Tick_Last
+};
+
+//-----------------------------------------------------------------------------
+const char* GetTickAsString(int tick)
+{
+  switch ( tick )
+    {
+    case Tick_ProcessSample: return "ProcessSample";
+    case Tick_FilterChannel: return "FilterChannel";
+    case Tick_FilterAll: return "FilterAll";
+    case Tick_InputEvent: return "InputEvent";
+    default: return "";
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Filter one sample, only counting the allocations of the filtering tick, not the
+// tracker update of the input transform node. Returns false if the sample is not processed.
+// The input data modified event of the module node is included in the tick driven by the
+// modified event of the input transform node. Samples of this tick are timestamped with the clock,
+// so the explicit timestamps of the other ticks start at firstTimestamp, before the clock.
+bool FilterSample(vtkSlicerTransformSmootherLogic* logic, vtkMRMLTransformSmootherNode* tsNode,
+                  int tick, double firstTimestamp, int sampleIndex,
+                  vtkMatrix4x4* inputMatrix, vtkMatrix4x4* outputMatrix, bool count)
+{
+  const double timestamp = firstTimestamp + sampleIndex * SamplingPeriod;
+  SetSampleMatrix( inputMatrix, sampleIndex );
+  if ( tick == Tick_ProcessSample )
+    {
+    CountAllocations = count;
+    const bool processed = logic->ProcessSample( tsNode, inputMatrix, timestamp, outputMatrix );
+    CountAllocations = false;
+    return processed;
+    }
+
+  tsNode->GetInputTransformNode()->SetMatrixTransformToParent( inputMatrix );
+  CountAllocations = count;
+  if ( tick == Tick_FilterChannel )
+    {
+    logic->FilterChannel( tsNode, 0, timestamp );
+    }
+  else if ( tick == Tick_FilterAll )
+    {
+    logic->FilterAll( timestamp );
+    }
+  else
+    {
+    tsNode->GetInputTransformNode()->InvokeEvent( vtkCommand::ModifiedEvent );
+    }
+  CountAllocations = false;
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherLogicAllocationTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  vtkNew<vtkMRMLLinearTransformNode> inputNode;
+  scene->AddNode( inputNode.GetPointer() );
+  vtkNew<vtkMRMLLinearTransformNode> outputNode;
+  scene->AddNode( outputNode.GetPointer() );
+
+  vtkNew<vtkMRMLTransformSmootherNode> tsNode;
+  scene->AddNode( tsNode.GetPointer() );
+  tsNode->SetAndObserveInputTransformNodeID( inputNode->GetID() );
+  tsNode->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+  tsNode->SetCutOffFrequency( 5.0 );
+  tsNode->FilterActivatedOn();
+
+  // Samples are filtered by the ticks, not when the input node is modified
+  inputNode->SetDisableModifiedEvent( 1 );
+
+  vtkNew<vtkMatrix4x4> inputMatrix;
+  vtkNew<vtkMatrix4x4> outputMatrix;
+  vtkNew<vtkMatrix4x4> filteredMatrix;
+
+  const int numberOfWarmUpSamples = 10;
+  const int numberOfSamples = 1000;
+  const double firstTimestamp = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - SamplingPeriod
+    * Tick_Last * vtkMRMLTransformSmootherNode::FilterMode_Last * ( numberOfWarmUpSamples + numberOfSamples );
+  int sampleIndex = 0;
+  for (int tick = 0; tick < Tick_Last; ++tick)
+    {
+    for (int filterMode = 0; filterMode < vtkMRMLTransformSmootherNode::FilterMode_Last; ++filterMode)
+      {
+      tsNode->SetFilterMode( filterMode );
+
+      // Warm-up: the first sample creates the filter state
+      for (int i = 0; i < numberOfWarmUpSamples; ++i, ++sampleIndex)
+        {
+        FilterSample( logic.GetPointer(), tsNode.GetPointer(), tick, firstTimestamp, sampleIndex,
+                      inputMatrix.GetPointer(), outputMatrix.GetPointer(), false );
+        }
+      outputNode->GetMatrixTransformToParent( filteredMatrix.GetPointer() );
+      const double warmUpTranslation = filteredMatrix->GetElement( 0, 3 );
+
+      // Steady state: filtering, including the write to the filtered transform node, must not allocate
+      int numberOfProcessedSamples = 0;
+      NumberOfAllocations = 0;
+      for (int i = 0; i < numberOfSamples; ++i, ++sampleIndex)
+        {
+        if ( FilterSample( logic.GetPointer(), tsNode.GetPointer(), tick, firstTimestamp, sampleIndex,
+                           inputMatrix.GetPointer(), outputMatrix.GetPointer(), true ) )
+          {
+          ++numberOfProcessedSamples;
+          }
+        }
+
+      if ( numberOfProcessedSamples != numberOfSamples )
+        {
+        std::cerr << "Line " << __LINE__ << ": " << GetTickAsString( tick ) << ", "
+                  << vtkMRMLTransformSmootherNode::GetFilterModeAsString( filterMode )
+                  << " filter: expected " << numberOfSamples
+                  << " processed samples, got " << numberOfProcessedSamples << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      outputNode->GetMatrixTransformToParent( filteredMatrix.GetPointer() );
+      if ( tick != Tick_ProcessSample && filteredMatrix->GetElement( 0, 3 ) == warmUpTranslation )
+        {
+        std::cerr << "Line " << __LINE__ << ": " << GetTickAsString( tick ) << ", "
+                  << vtkMRMLTransformSmootherNode::GetFilterModeAsString( filterMode )
+                  << " filter: filtered transform node not written" << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      if ( NumberOfAllocations > 0 )
+        {
+        std::cerr << "Line " << __LINE__ << ": " << GetTickAsString( tick ) << ", "
+                  << vtkMRMLTransformSmootherNode::GetFilterModeAsString( filterMode )
+                  << " filter performed " << NumberOfAllocations
+                  << " heap allocations in " << numberOfSamples << " ticks, expected none" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
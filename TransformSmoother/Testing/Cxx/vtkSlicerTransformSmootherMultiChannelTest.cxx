@@ -0,0 +1,196 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+typedef std::vector< vtkSmartPointer< vtkMRMLLinearTransformNode > > TransformNodeList;
+
+//-----------------------------------------------------------------------------
+vtkMRMLLinearTransformNode* AddTransformNode(vtkMRMLScene* scene, TransformNodeList& nodes)
+{
+  vtkSmartPointer< vtkMRMLLinearTransformNode > node = vtkSmartPointer< vtkMRMLLinearTransformNode >::New();
+  scene->AddNode( node );
+  // Samples are filtered explicitly by the test
+  node->SetDisableModifiedEvent( 1 );
+  nodes.push_back( node );
+  return node;
+}
+
+//-----------------------------------------------------------------------------
+void SetTranslation(vtkMRMLLinearTransformNode* node, double x)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement( 0, 3, x );
+  node->SetMatrixTransformToParent( matrix.GetPointer() );
+}
+
+//-----------------------------------------------------------------------------
+double GetTranslation(vtkMRMLLinearTransformNode* node)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  node->GetMatrixTransformToParent( matrix.GetPointer() );
+  return matrix->GetElement( 0, 3 );
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherMultiChannelTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  // One module node for all markers of a tracked tool, without filter so that the outputs are the inputs
+  const int numberOfChannels = 4;
+  TransformNodeList inputNodes;
+  TransformNodeList outputNodes;
+  vtkNew<vtkMRMLTransformSmootherNode> tsNode;
+  scene->AddNode( tsNode.GetPointer() );
+  for (int channel = 0; channel < numberOfChannels; ++channel)
+    {
+    vtkMRMLLinearTransformNode* inputNode = AddTransformNode( scene.GetPointer(), inputNodes );
+    vtkMRMLLinearTransformNode* outputNode = AddTransformNode( scene.GetPointer(), outputNodes );
+    if ( tsNode->AddChannel( inputNode->GetID(), outputNode->GetID() ) != channel )
+      {
+      std::cerr << "Line " << __LINE__ << ": channel " << channel << " added at a different index" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if ( tsNode->GetNumberOfChannels() != numberOfChannels || tsNode->GetInputTransformNode() != inputNodes[0].GetPointer() )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << numberOfChannels << " channels, got "
+              << tsNode->GetNumberOfChannels() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Module node with a single channel, after the first one
+  vtkMRMLLinearTransformNode* otherInputNode = AddTransformNode( scene.GetPointer(), inputNodes );
+  vtkMRMLLinearTransformNode* otherOutputNode = AddTransformNode( scene.GetPointer(), outputNodes );
+  vtkNew<vtkMRMLTransformSmootherNode> otherTsNode;
+  scene->AddNode( otherTsNode.GetPointer() );
+  otherTsNode->SetAndObserveInputTransformNodeID( otherInputNode->GetID() );
+  otherTsNode->SetAndObserveFilteredTransformNodeID( otherOutputNode->GetID() );
+
+  // All channels are filtered by Filter, a single one by FilterChannel
+  for (int channel = 0; channel < numberOfChannels; ++channel)
+    {
+    SetTranslation( inputNodes[channel], 10.0 + channel );
+    }
+  logic->Filter( tsNode.GetPointer(), 0.01 );
+  for (int channel = 0; channel < numberOfChannels; ++channel)
+    {
+    SetTranslation( inputNodes[channel], 20.0 + channel );
+    }
+  logic->FilterChannel( tsNode.GetPointer(), 2, 0.02 );
+  for (int channel = 0; channel < numberOfChannels; ++channel)
+    {
+    const double expectedTranslation = ( channel == 2 ? 20.0 : 10.0 ) + channel;
+    if ( GetTranslation( outputNodes[channel] ) != expectedTranslation )
+      {
+      std::cerr << "Line " << __LINE__ << ": channel " << channel << " output is " << GetTranslation( outputNodes[channel] )
+                << ", expected " << expectedTranslation << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Clearing the input of a middle channel leaves an empty slot, the other channels keep their pairs
+  tsNode->SetAndObserveNthInputTransformNodeID( 2, NULL );
+  if ( tsNode->GetNumberOfChannels() != numberOfChannels || tsNode->GetNthInputTransformNode( 2 ) != NULL
+    || tsNode->GetNthFilteredTransformNode( 2 ) != outputNodes[2].GetPointer() )
+    {
+    std::cerr << "Line " << __LINE__ << ": clearing the input of channel 2 changed the channels" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int channel = 0; channel < numberOfChannels; ++channel)
+    {
+    if ( channel != 2 && ( tsNode->GetNthInputTransformNode( channel ) != inputNodes[channel].GetPointer()
+      || tsNode->GetNthFilteredTransformNode( channel ) != outputNodes[channel].GetPointer() ) )
+      {
+      std::cerr << "Line " << __LINE__ << ": channel " << channel << " paired with other transforms after clearing channel 2" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  tsNode->SetAndObserveNthInputTransformNodeID( 2, inputNodes[2]->GetID() );
+
+  // A channel added to a module node that only has an input transform is a new pair
+  TransformNodeList pairNodes;
+  vtkNew<vtkMRMLTransformSmootherNode> inputOnlyTsNode;
+  scene->AddNode( inputOnlyTsNode.GetPointer() );
+  inputOnlyTsNode->SetAndObserveInputTransformNodeID( AddTransformNode( scene.GetPointer(), pairNodes )->GetID() );
+  vtkMRMLLinearTransformNode* pairInputNode = AddTransformNode( scene.GetPointer(), pairNodes );
+  vtkMRMLLinearTransformNode* pairOutputNode = AddTransformNode( scene.GetPointer(), pairNodes );
+  if ( inputOnlyTsNode->AddChannel( pairInputNode->GetID(), pairOutputNode->GetID() ) != 1
+    || inputOnlyTsNode->GetNthInputTransformNode( 1 ) != pairInputNode
+    || inputOnlyTsNode->GetNthFilteredTransformNode( 1 ) != pairOutputNode
+    || inputOnlyTsNode->GetFilteredTransformNode() != NULL )
+    {
+    std::cerr << "Line " << __LINE__ << ": channel added to a module node with an input only is not a new pair" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Removing a channel keeps the other channels and module nodes
+  tsNode->RemoveChannel( 1 );
+  inputNodes.erase( inputNodes.begin() + 1 );
+  outputNodes.erase( outputNodes.begin() + 1 );
+  if ( tsNode->GetNumberOfChannels() != numberOfChannels - 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": channel not removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int channel = 0; channel < numberOfChannels - 1; ++channel)
+    {
+    if ( tsNode->GetNthInputTransformNode( channel ) != inputNodes[channel].GetPointer()
+      || tsNode->GetNthFilteredTransformNode( channel ) != outputNodes[channel].GetPointer() )
+      {
+      std::cerr << "Line " << __LINE__ << ": channel " << channel << " paired with other transforms after removing channel 1" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  for (size_t i = 0; i < inputNodes.size(); ++i)
+    {
+    SetTranslation( inputNodes[i], 30.0 + i );
+    }
+  logic->FilterAll( 0.03 );
+  for (size_t i = 0; i < outputNodes.size(); ++i)
+    {
+    if ( GetTranslation( outputNodes[i] ) != 30.0 + i )
+      {
+      std::cerr << "Line " << __LINE__ << ": output " << i << " is " << GetTranslation( outputNodes[i] )
+                << " after the removal of a channel, expected " << 30.0 + i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
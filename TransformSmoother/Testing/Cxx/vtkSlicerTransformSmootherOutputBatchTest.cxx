@@ -0,0 +1,125 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+// Translations of all filtered transforms, seen by the observers of the filtered transform nodes
+struct ObservedOutputs
+{
+  std::vector< vtkMRMLLinearTransformNode* > OutputNodes;
+  std::vector< double > ObservedTranslations;
+  int NumberOfEvents;
+};
+
+//-----------------------------------------------------------------------------
+void OnOutputModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+{
+  ObservedOutputs* outputs = static_cast< ObservedOutputs* >( clientData );
+  ++outputs->NumberOfEvents;
+  vtkNew<vtkMatrix4x4> matrix;
+  for (size_t i = 0; i < outputs->OutputNodes.size(); ++i)
+    {
+    outputs->OutputNodes[i]->GetMatrixTransformToParent( matrix.GetPointer() );
+    outputs->ObservedTranslations.push_back( matrix->GetElement( 0, 3 ) );
+    }
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherOutputBatchTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  ObservedOutputs outputs;
+  outputs.NumberOfEvents = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback( OnOutputModified );
+  callback->SetClientData( &outputs );
+
+  // Several tools, without filter so that the filtered transforms are the input transforms
+  const int numberOfTools = 4;
+  std::vector< vtkSmartPointer< vtkMRMLLinearTransformNode > > inputNodes;
+  for (int i = 0; i < numberOfTools; ++i)
+    {
+    vtkSmartPointer< vtkMRMLLinearTransformNode > inputNode = vtkSmartPointer< vtkMRMLLinearTransformNode >::New();
+    scene->AddNode( inputNode );
+    inputNode->SetDisableModifiedEvent( 1 );
+    inputNodes.push_back( inputNode );
+    vtkSmartPointer< vtkMRMLLinearTransformNode > outputNode = vtkSmartPointer< vtkMRMLLinearTransformNode >::New();
+    scene->AddNode( outputNode );
+    outputs.OutputNodes.push_back( outputNode );
+    vtkSmartPointer< vtkMRMLTransformSmootherNode > tsNode = vtkSmartPointer< vtkMRMLTransformSmootherNode >::New();
+    scene->AddNode( tsNode );
+    tsNode->SetAndObserveInputTransformNodeID( inputNode->GetID() );
+    tsNode->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+    outputNode->AddObserver( vtkCommand::ModifiedEvent, callback.GetPointer() );
+    }
+
+  // All tools move at once, observers of each output must see all outputs moved
+  vtkNew<vtkMatrix4x4> inputMatrix;
+  for (int tick = 1; tick <= 3; ++tick)
+    {
+    for (int i = 0; i < numberOfTools; ++i)
+      {
+      inputMatrix->SetElement( 0, 3, 10.0 * tick + i );
+      inputNodes[i]->SetMatrixTransformToParent( inputMatrix.GetPointer() );
+      }
+    outputs.NumberOfEvents = 0;
+    outputs.ObservedTranslations.clear();
+    logic->FilterAll( 0.01 * tick );
+
+    if ( outputs.NumberOfEvents < numberOfTools )
+      {
+      std::cerr << "Line " << __LINE__ << ": tick " << tick << ": " << outputs.NumberOfEvents
+                << " modified events for " << numberOfTools << " filtered transforms" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (size_t j = 0; j < outputs.ObservedTranslations.size(); ++j)
+      {
+      const double expectedTranslation = 10.0 * tick + static_cast<int>( j % numberOfTools );
+      if ( outputs.ObservedTranslations[j] != expectedTranslation )
+        {
+        std::cerr << "Line " << __LINE__ << ": tick " << tick << ": observer saw translation "
+                  << outputs.ObservedTranslations[j] << " instead of " << expectedTranslation
+                  << ", filtered transforms were not all written before notifying observers" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Tool at rest with tracking noise (0.05 mm, 0.05 deg), rotated by angle (in degrees) around z
+void SetSampleMatrix(vtkMatrix4x4* matrix, int sampleIndex, double x, double angle)
+{
+  const double noise = ( sampleIndex % 2 ) ? 0.05 : -0.05;
+  const double radians = ( angle + noise ) * 3.14159265358979 / 180.0;
+  matrix->Identity();
+  matrix->SetElement( 0, 0, cos( radians ) );
+  matrix->SetElement( 0, 1, -sin( radians ) );
+  matrix->SetElement( 1, 0, sin( radians ) );
+  matrix->SetElement( 1, 1, cos( radians ) );
+  matrix->SetElement( 0, 3, x + noise );
+  matrix->SetElement( 1, 3, 20.0 );
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherOutputDeadbandTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  vtkNew<vtkMRMLLinearTransformNode> inputNode;
+  scene->AddNode( inputNode.GetPointer() );
+  vtkNew<vtkMRMLLinearTransformNode> outputNode;
+  scene->AddNode( outputNode.GetPointer() );
+
+  // Without filter, so that the output is the input
+  vtkNew<vtkMRMLTransformSmootherNode> tsNode;
+  scene->AddNode( tsNode.GetPointer() );
+  tsNode->SetAndObserveInputTransformNodeID( inputNode->GetID() );
+  tsNode->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+  tsNode->SetOutputTranslationDeadband( 0.5 );
+  tsNode->SetOutputRotationDeadband( 1.0 );
+  inputNode->SetDisableModifiedEvent( 1 );
+
+  // Only the first sample of the tool at rest is written
+  vtkNew<vtkMatrix4x4> inputMatrix;
+  vtkNew<vtkMatrix4x4> outputMatrix;
+  const int numberOfSamples = 100;
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    SetSampleMatrix( inputMatrix.GetPointer(), i, 10.0, 0.0 );
+    inputNode->SetMatrixTransformToParent( inputMatrix.GetPointer() );
+    logic->Filter( tsNode.GetPointer(), i * 0.01 );
+    }
+  outputNode->GetMatrixTransformToParent( outputMatrix.GetPointer() );
+  if ( logic->GetNumberOfSuppressedWrites( tsNode.GetPointer() ) != numberOfSamples - 1
+    || fabs( outputMatrix->GetElement( 0, 3 ) - ( 10.0 - 0.05 ) ) > 1e-9 )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << numberOfSamples - 1 << " suppressed writes, got "
+              << logic->GetNumberOfSuppressedWrites( tsNode.GetPointer() ) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Translations and rotations beyond the deadband are written
+  const double moves[2][2] = { { 11.0, 0.0 }, { 11.0, 2.0 } };
+  for (int move = 0; move < 2; ++move)
+    {
+    SetSampleMatrix( inputMatrix.GetPointer(), numberOfSamples + move, moves[move][0], moves[move][1] );
+    inputNode->SetMatrixTransformToParent( inputMatrix.GetPointer() );
+    logic->Filter( tsNode.GetPointer(), ( numberOfSamples + move ) * 0.01 );
+    outputNode->GetMatrixTransformToParent( outputMatrix.GetPointer() );
+    for (int row = 0; row < 3; ++row)
+      {
+      for (int column = 0; column < 4; ++column)
+        {
+        if ( fabs( outputMatrix->GetElement( row, column ) - inputMatrix->GetElement( row, column ) ) > 1e-9 )
+          {
+          std::cerr << "Line " << __LINE__ << ": move " << move << " beyond the deadband not written" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  if ( logic->GetNumberOfSuppressedWrites( tsNode.GetPointer() ) != numberOfSamples - 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": write beyond the deadband suppressed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+void OnOutputModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+{
+  ++( *static_cast< int* >( clientData ) );
+}
+
+//-----------------------------------------------------------------------------
+// Rotation by angle (in degrees) around z and translation along x
+void SetPose(vtkMRMLLinearTransformNode* node, double angle, double x)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  const double radians = vtkMath::RadiansFromDegrees( angle );
+  matrix->SetElement( 0, 0, cos( radians ) );
+  matrix->SetElement( 0, 1, -sin( radians ) );
+  matrix->SetElement( 1, 0, sin( radians ) );
+  matrix->SetElement( 1, 1, cos( radians ) );
+  matrix->SetElement( 0, 3, x );
+  node->SetMatrixTransformToParent( matrix.GetPointer() );
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherOutputFusionTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  // Two redundant sensors of one tool, without filter, writing the same filtered transform
+  vtkNew<vtkMRMLLinearTransformNode> outputNode;
+  scene->AddNode( outputNode.GetPointer() );
+  const int numberOfSensors = 2;
+  const double weights[numberOfSensors] = { 1.0, 3.0 };
+  const double angles[numberOfSensors] = { 10.0, 30.0 };
+  const double translations[numberOfSensors] = { 0.0, 10.0 };
+  vtkNew<vtkMRMLLinearTransformNode> inputNodes[numberOfSensors];
+  vtkNew<vtkMRMLTransformSmootherNode> tsNodes[numberOfSensors];
+  for (int i = 0; i < numberOfSensors; ++i)
+    {
+    scene->AddNode( inputNodes[i].GetPointer() );
+    inputNodes[i]->SetDisableModifiedEvent( 1 );
+    scene->AddNode( tsNodes[i].GetPointer() );
+    tsNodes[i]->SetAndObserveInputTransformNodeID( inputNodes[i]->GetID() );
+    tsNodes[i]->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+    tsNodes[i]->SetFusionWeight( weights[i] );
+    SetPose( inputNodes[i].GetPointer(), angles[i], translations[i] );
+    }
+
+  int numberOfEvents = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback( OnOutputModified );
+  callback->SetClientData( &numberOfEvents );
+  outputNode->AddObserver( vtkCommand::ModifiedEvent, callback.GetPointer() );
+
+  // The shared output is written once, with the weighted average
+  logic->FilterAll( 0.01 );
+  if ( numberOfEvents != 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": " << numberOfEvents << " modified events of the shared output, expected 1" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // For rotations around one axis, the average maximizes sum(w * cos(angle - angle_i))
+  double sinSum = 0.0;
+  double cosSum = 0.0;
+  double translationSum = 0.0;
+  double weightSum = 0.0;
+  for (int i = 0; i < numberOfSensors; ++i)
+    {
+    sinSum += weights[i] * sin( vtkMath::RadiansFromDegrees( angles[i] ) );
+    cosSum += weights[i] * cos( vtkMath::RadiansFromDegrees( angles[i] ) );
+    translationSum += weights[i] * translations[i];
+    weightSum += weights[i];
+    }
+  const double expectedAngle = vtkMath::DegreesFromRadians( atan2( sinSum, cosSum ) );
+  vtkNew<vtkMatrix4x4> outputMatrix;
+  outputNode->GetMatrixTransformToParent( outputMatrix.GetPointer() );
+  const double angle = vtkMath::DegreesFromRadians( atan2( outputMatrix->GetElement( 1, 0 ), outputMatrix->GetElement( 0, 0 ) ) );
+  if ( fabs( angle - expectedAngle ) > 1e-6 || fabs( outputMatrix->GetElement( 0, 3 ) - translationSum / weightSum ) > 1e-9 )
+    {
+    std::cerr << "Line " << __LINE__ << ": fused rotation " << angle << " deg and translation " << outputMatrix->GetElement( 0, 3 )
+              << ", expected " << expectedAngle << " deg and " << translationSum / weightSum << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A single sensor updated uses the latest pose of the other one
+  SetPose( inputNodes[0].GetPointer(), angles[1], translations[1] );
+  logic->Filter( tsNodes[0].GetPointer(), 0.02 );
+  outputNode->GetMatrixTransformToParent( outputMatrix.GetPointer() );
+  if ( fabs( atan2( outputMatrix->GetElement( 1, 0 ), outputMatrix->GetElement( 0, 0 ) ) - vtkMath::RadiansFromDegrees( angles[1] ) ) > 1e-9
+    || fabs( outputMatrix->GetElement( 0, 3 ) - translations[1] ) > 1e-9 )
+    {
+    std::cerr << "Line " << __LINE__ << ": fused pose does not match the sensors in the same pose" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Filtering driven by the modified events of the inputs: the shared output is written once per tick,
+  // when the filtered transforms are published, not for each input
+  int numberOfPendingEvents = 0;
+  vtkNew<vtkCallbackCommand> pendingCallback;
+  pendingCallback->SetCallback( OnOutputModified );
+  pendingCallback->SetClientData( &numberOfPendingEvents );
+  logic->AddObserver( vtkSlicerTransformSmootherLogic::FusedOutputsPendingEvent, pendingCallback.GetPointer() );
+  numberOfEvents = 0;
+  for (int i = 0; i < numberOfSensors; ++i)
+    {
+    inputNodes[i]->SetDisableModifiedEvent( 0 );
+    SetPose( inputNodes[i].GetPointer(), angles[0], translations[0] );
+    }
+  if ( numberOfEvents != 0 || numberOfPendingEvents != 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": " << numberOfEvents << " modified events of the shared output and "
+              << numberOfPendingEvents << " pending events before publishing, expected 0 and 1" << std::endl;
+    return EXIT_FAILURE;
+    }
+  logic->PublishFilteredTransforms();
+  logic->PublishFilteredTransforms();
+  outputNode->GetMatrixTransformToParent( outputMatrix.GetPointer() );
+  if ( numberOfEvents != 1 || fabs( outputMatrix->GetElement( 0, 3 ) - translations[0] ) > 1e-9 )
+    {
+    std::cerr << "Line " << __LINE__ << ": " << numberOfEvents << " modified events of the shared output after publishing"
+              << " and translation " << outputMatrix->GetElement( 0, 3 ) << ", expected 1 and " << translations[0] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
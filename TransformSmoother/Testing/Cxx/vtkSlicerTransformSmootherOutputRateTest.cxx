@@ -0,0 +1,145 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherFilterBank.h"
+
+// VTK includes
+#include <vtkSetGet.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Tool moving at constant linear and angular velocity: 50 mm/s along x, 1 rad/s around z
+void GetPose(double t, double rotation[4], double translation[3])
+{
+  rotation[0] = cos( t / 2.0 );
+  rotation[1] = 0.0;
+  rotation[2] = 0.0;
+  rotation[3] = sin( t / 2.0 );
+  translation[0] = 50.0 * t;
+  translation[1] = 20.0;
+  translation[2] = -10.0;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherOutputRateTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // 400 Hz input with irregular timestamps, 60 Hz output
+  const double inputPeriod = 0.0025;
+  const double outputRate = 60.0;
+  const int numberOfSamples = 4000;
+
+  // Cutoff frequency so high that the filtered pose is the input pose, so that
+  // the interpolated outputs can be compared to the exact motion
+  vtkSlicerTransformSmootherFilterBank filters;
+  filters.AddFilter();
+  vtkSlicerTransformSmootherFilterBank::FilterParameters parameters;
+  parameters.Activated = true;
+  parameters.CutOffFrequency = 1e12;
+  parameters.InterpolationMode = vtkSlicerTransformSmootherFilterBank::InterpolationSlerp;
+  parameters.OutputRate = outputRate;
+  filters.SetFilterParameters( 0, parameters );
+
+  int numberOfOutputs = 0;
+  double firstOutputTimestamp = 0.0;
+  double lastTimestamp = 0.0;
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    const double timestamp = i * inputPeriod + 0.0005 * ( i % 3 );
+    double rotation[4];
+    double translation[3];
+    GetPose( timestamp, rotation, translation );
+    if ( !filters.SetSample( 0, timestamp, rotation, translation ) )
+      {
+      std::cerr << "Line " << __LINE__ << ": sample " << i << " rejected" << std::endl;
+      return EXIT_FAILURE;
+      }
+    lastTimestamp = timestamp;
+
+    double outputTimestamp = 0.0;
+    if ( !filters.GetResampledOutputPose( 0, outputTimestamp, rotation, translation ) )
+      {
+      continue;
+      }
+
+    // Outputs are on a regular grid starting at the first sample
+    if ( numberOfOutputs == 0 )
+      {
+      firstOutputTimestamp = outputTimestamp;
+      }
+    const double expectedOutputTimestamp = firstOutputTimestamp + numberOfOutputs / outputRate;
+    if ( fabs( outputTimestamp - expectedOutputTimestamp ) > 1e-9 || outputTimestamp > timestamp )
+      {
+      std::cerr << "Line " << __LINE__ << ": output " << numberOfOutputs << " at " << outputTimestamp
+                << " s, expected " << expectedOutputTimestamp << " s" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // Interpolation at the output time is exact for this motion
+    double expectedRotation[4];
+    double expectedTranslation[3];
+    GetPose( outputTimestamp, expectedRotation, expectedTranslation );
+    const double dot = expectedRotation[0] * rotation[0] + expectedRotation[1] * rotation[1]
+      + expectedRotation[2] * rotation[2] + expectedRotation[3] * rotation[3];
+    if ( fabs( translation[0] - expectedTranslation[0] ) > 1e-6 || fabs( dot ) < 1.0 - 1e-12 )
+      {
+      std::cerr << "Line " << __LINE__ << ": output " << numberOfOutputs << " is not interpolated at its output time, "
+                << "translation error " << translation[0] - expectedTranslation[0] << " mm" << std::endl;
+      return EXIT_FAILURE;
+      }
+    ++numberOfOutputs;
+
+    // Asking again for the same sample gives no output
+    if ( filters.GetResampledOutputPose( 0, outputTimestamp, rotation, translation ) )
+      {
+      std::cerr << "Line " << __LINE__ << ": output written twice for sample " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  const int expectedNumberOfOutputs = static_cast<int>( floor( ( lastTimestamp - firstOutputTimestamp ) * outputRate ) ) + 1;
+  if ( numberOfOutputs != expectedNumberOfOutputs )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << expectedNumberOfOutputs << " outputs, got "
+              << numberOfOutputs << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Without output rate every sample is written
+  parameters.OutputRate = 0.0;
+  filters.SetFilterParameters( 0, parameters );
+  double rotation[4];
+  double translation[3];
+  GetPose( lastTimestamp + inputPeriod, rotation, translation );
+  filters.SetSample( 0, lastTimestamp + inputPeriod, rotation, translation );
+  double outputTimestamp = 0.0;
+  if ( !filters.GetResampledOutputPose( 0, outputTimestamp, rotation, translation )
+    || outputTimestamp != lastTimestamp + inputPeriod )
+    {
+    std::cerr << "Line " << __LINE__ << ": sample not written without output rate" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherPoseHistory.h"
+
+// VTK includes
+#include <vtkSetGet.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherPoseHistoryTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const int capacity = 100;
+  const int numberOfPoses = 250;
+  const double period = 0.01;
+
+  vtkSlicerTransformSmootherPoseHistory history;
+  double timestamp = 0.0;
+  int before = 0;
+  int after = 0;
+  double weight = 0.0;
+  if ( history.FindPoses( 0.0, before, after, weight ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": empty history found a pose" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Fill the history more than twice, so that the oldest poses are overwritten
+  history.SetCapacity( capacity );
+  const double rotation[4] = { 1.0, 0.0, 0.0, 0.0 };
+  for (int i = 0; i < numberOfPoses; ++i)
+    {
+    const double translation[3] = { static_cast<double>( i ), 0.0, 0.0 };
+    if ( !history.AddPose( i * period, rotation, translation ) )
+      {
+      std::cerr << "Line " << __LINE__ << ": pose " << i << " rejected" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  const double translation[3] = { 0.0, 0.0, 0.0 };
+  if ( history.AddPose( ( numberOfPoses - 1 ) * period, rotation, translation ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": pose that is not newer accepted" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( history.GetNumberOfPoses() != capacity )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << capacity << " poses, got " << history.GetNumberOfPoses() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Poses are in time order, starting with the oldest kept pose
+  const int firstPose = numberOfPoses - capacity;
+  for (int i = 0; i < capacity; ++i)
+    {
+    double poseRotation[4];
+    double poseTranslation[3];
+    history.GetPose( i, timestamp, poseRotation, poseTranslation );
+    if ( poseTranslation[0] != firstPose + i || timestamp != ( firstPose + i ) * period )
+      {
+      std::cerr << "Line " << __LINE__ << ": pose " << i << " is pose " << poseTranslation[0]
+                << ", expected " << firstPose + i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Times between two poses
+  for (int i = firstPose; i < numberOfPoses - 1; ++i)
+    {
+    timestamp = ( i + 0.25 ) * period;
+    if ( !history.FindPoses( timestamp, before, after, weight )
+      || before != i - firstPose || after != before + 1 || fabs( weight - 0.25 ) > 1e-9 )
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong poses around " << timestamp << " s: "
+                << before << ", " << after << " (weight " << weight << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Times of the oldest and latest poses are in the history, times outside are not
+  if ( !history.FindPoses( firstPose * period, before, after, weight ) || before != 0 || weight != 0.0 )
+    {
+    std::cerr << "Line " << __LINE__ << ": oldest pose not found" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( !history.FindPoses( ( numberOfPoses - 1 ) * period, before, after, weight )
+    || before != capacity - 1 || after != capacity - 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": latest pose not found" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( history.FindPoses( ( firstPose - 0.5 ) * period, before, after, weight )
+    || history.FindPoses( numberOfPoses * period, before, after, weight ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": pose found outside of the history" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Changing the capacity discards the poses
+  history.SetCapacity( capacity / 2 );
+  if ( history.GetNumberOfPoses() != 0 || history.GetCapacity() != capacity / 2 )
+    {
+    std::cerr << "Line " << __LINE__ << ": history not reset" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,535 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Headless replay of pose streams through the filters of the logic, with synthetic timestamps,
+// as fast as possible. No timer or GUI is involved, so results only depend on the inputs.
+//
+// Usage: vtkSlicerTransformSmootherReplay [--motion name] [--mode name] [--rate Hz] [--duration s]
+//          [--noise mm] [--rotation-noise deg] [--jitter s] [--seed N] [--trajectory file]
+//          [--max-translation-error mm] [--max-rotation-error deg] [--output results.json]
+//
+// Scripted motions (static, constant velocity, circle, step) are sampled at the given rate,
+// with Gaussian noise added to the ground truth poses and optional timestamp jitter (all motions,
+// or the given one). A trajectory
+// file recorded by the logic (see vtkSlicerTransformSmootherLogic::StartRecording) can be replayed
+// instead; the recorded samples are then the reference of the error.
+//
+// Each stream is replayed through every filter mode (or the given one). Results are written as
+// JSON (to standard output if no output file is given): throughput in samples per second and
+// RMS/maximum error of the filtered poses against ground truth, after a warm-up of WarmUpTime.
+// The program fails if an RMS error exceeds the given maximum, so that it can be used to catch
+// accuracy regressions.
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherFilterBank.h"
+#include "vtkSlicerTransformSmootherLogic.h"
+#include "vtkSlicerTransformSmootherTrajectoryReader.h"
+#include "vtkMRMLTransformSmootherNode.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+namespace
+{
+
+// Errors are not collected while the filters settle on the first samples
+const double WarmUpTime = 0.5;
+
+const int NumberOfMotions = 4;
+const char* MotionNames[NumberOfMotions] = { "Static", "ConstantVelocity", "Circle", "Step" };
+
+struct ReplayOptions
+{
+  ReplayOptions()
+  {
+    this->Motion = -1;
+    this->FilterMode = -1;
+    this->Rate = 250.0;
+    this->Duration = 10.0;
+    this->Noise = 0.25;
+    this->RotationNoise = 0.1;
+    this->Jitter = 0.0;
+    this->Seed = 1;
+    this->TrajectoryFileName = NULL;
+    this->MaximumTranslationError = -1.0;
+    this->MaximumRotationError = -1.0;
+    this->OutputFileName = NULL;
+  }
+  int Motion; // all motions if -1
+  int FilterMode; // all modes if -1
+  double Rate; // Hz
+  double Duration; // s
+  double Noise; // mm
+  double RotationNoise; // deg
+  double Jitter; // s
+  unsigned int Seed;
+  const char* TrajectoryFileName;
+  double MaximumTranslationError; // mm, not checked if negative
+  double MaximumRotationError; // deg, not checked if negative
+  const char* OutputFileName;
+};
+
+// Pose stream: measured samples and the ground truth poses at the same timestamps
+struct PoseStream
+{
+  std::string Name;
+  std::vector<double> Timestamps;
+  vtkSlicerTransformSmootherPoseArrays Samples;
+  vtkSlicerTransformSmootherPoseArrays GroundTruth;
+};
+
+struct ReplayResult
+{
+  std::string StreamName;
+  std::string FilterName;
+  int NumberOfSamples;
+  double SamplesPerSecond;
+  double RmsTranslationError;
+  double MaximumTranslationError;
+  double RmsRotationError;
+  double MaximumRotationError;
+};
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers, the same on all platforms
+class RandomGenerator
+{
+public:
+  explicit RandomGenerator(unsigned int seed) : State( seed ) {}
+
+  /// Uniform in [0, 1)
+  double Uniform()
+  {
+    this->State = this->State * 1664525u + 1013904223u;
+    return ( this->State >> 8 ) / 16777216.0;
+  }
+
+  /// Gaussian with zero mean and unit standard deviation (Box-Muller)
+  double Gaussian()
+  {
+    const double u = 1.0 - this->Uniform();
+    const double v = this->Uniform();
+    return sqrt( -2.0 * log( u ) ) * cos( 2.0 * vtkMath::Pi() * v );
+  }
+
+private:
+  vtkTypeUInt32 State;
+};
+
+//-----------------------------------------------------------------------------
+// Rotation quaternion (w, x, y, z) of angle (in radians) around a unit axis
+void GetAxisAngleRotation(const double axis[3], double angle, double rotation[4])
+{
+  rotation[0] = cos( angle / 2.0 );
+  rotation[1] = axis[0] * sin( angle / 2.0 );
+  rotation[2] = axis[1] * sin( angle / 2.0 );
+  rotation[3] = axis[2] * sin( angle / 2.0 );
+}
+
+//-----------------------------------------------------------------------------
+// Ground truth pose of a scripted motion at time t (in seconds)
+void GetScriptedPose(int motion, double t, double duration, double rotation[4], double translation[3])
+{
+  const double zAxis[3] = { 0.0, 0.0, 1.0 };
+  translation[0] = 100.0;
+  translation[1] = -50.0;
+  translation[2] = 200.0;
+  GetAxisAngleRotation( zAxis, 0.0, rotation );
+  switch ( motion )
+    {
+    case 1: // constant velocity: 50 mm/s along x, 20 deg/s around z
+      translation[0] += 50.0 * t;
+      GetAxisAngleRotation( zAxis, vtkMath::RadiansFromDegrees( 20.0 * t ), rotation );
+      break;
+    case 2: // circle of 50 mm radius at 0.5 Hz, the tool facing the center
+      {
+      const double angle = 2.0 * vtkMath::Pi() * 0.5 * t;
+      translation[0] += 50.0 * cos( angle );
+      translation[1] += 50.0 * sin( angle );
+      GetAxisAngleRotation( zAxis, angle, rotation );
+      }
+      break;
+    case 3: // step of 20 mm and 30 deg half-way
+      if ( t >= duration / 2.0 )
+        {
+        translation[0] += 20.0;
+        GetAxisAngleRotation( zAxis, vtkMath::RadiansFromDegrees( 30.0 ), rotation );
+        }
+      break;
+    default: // static
+      break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void MakeScriptedStreams(const ReplayOptions& options, std::vector<PoseStream>& streams)
+{
+  const int numberOfSamples = std::max( 1, static_cast<int>( options.Duration * options.Rate ) );
+  for (int motion = 0; motion < NumberOfMotions; ++motion)
+    {
+    if ( options.Motion >= 0 && motion != options.Motion )
+      {
+      continue;
+      }
+    // Same noise sequence for all motions
+    RandomGenerator random( options.Seed );
+    streams.push_back( PoseStream() );
+    PoseStream& stream = streams.back();
+    stream.Name = MotionNames[motion];
+    stream.Timestamps.resize( numberOfSamples );
+    stream.Samples.Resize( numberOfSamples );
+    stream.GroundTruth.Resize( numberOfSamples );
+    for (int i = 0; i < numberOfSamples; ++i)
+      {
+      // Jitter is smaller than half the sampling period, so timestamps increase
+      const double maximumJitter = std::min( options.Jitter, 0.49 / options.Rate );
+      const double t = std::max( 0.0, i / options.Rate + maximumJitter * ( 2.0 * random.Uniform() - 1.0 ) );
+      stream.Timestamps[i] = t;
+      double rotation[4];
+      double translation[3];
+      GetScriptedPose( motion, t, options.Duration, rotation, translation );
+      stream.GroundTruth.SetPose( i, rotation, translation );
+
+      // Measurement noise: Gaussian translation, rotation around a random axis
+      double axis[3] = { random.Gaussian(), random.Gaussian(), random.Gaussian() };
+      if ( vtkMath::Normalize( axis ) == 0.0 )
+        {
+        axis[2] = 1.0;
+        }
+      double noiseRotation[4];
+      GetAxisAngleRotation( axis, vtkMath::RadiansFromDegrees( options.RotationNoise * random.Gaussian() ), noiseRotation );
+      double noisyRotation[4];
+      vtkMath::MultiplyQuaternion( noiseRotation, rotation, noisyRotation );
+      for (int k = 0; k < 3; ++k)
+        {
+        translation[k] += options.Noise * random.Gaussian();
+        }
+      stream.Samples.SetPose( i, noisyRotation, translation );
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool MakeTrajectoryStream(const char* fileName, std::vector<PoseStream>& streams)
+{
+  vtkSlicerTransformSmootherTrajectoryReader reader;
+  if ( !reader.Open( fileName ) )
+    {
+    std::cerr << "Cannot read trajectory file " << fileName << std::endl;
+    return false;
+    }
+  const int numberOfSamples = static_cast<int>( reader.GetNumberOfRecords() );
+  streams.push_back( PoseStream() );
+  PoseStream& stream = streams.back();
+  stream.Name = "Trajectory";
+  stream.Timestamps.resize( numberOfSamples );
+  stream.Samples.Resize( numberOfSamples );
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    double rotation[4];
+    double translation[3];
+    reader.GetSample( i, stream.Timestamps[i], rotation, translation );
+    stream.Samples.SetPose( i, rotation, translation );
+    }
+  // No ground truth is known, the error is the deviation from the recorded samples
+  stream.GroundTruth = stream.Samples;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Replay a stream through a module node of a new scene, the way a tracker updates the input
+// transform node, and compare the filtered transforms to the ground truth.
+// If filterMode is negative the filter is not activated (errors are the ones of the samples).
+ReplayResult Replay(const PoseStream& stream, int filterMode)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+  vtkNew<vtkMRMLLinearTransformNode> inputNode;
+  scene->AddNode( inputNode.GetPointer() );
+  vtkNew<vtkMRMLLinearTransformNode> outputNode;
+  scene->AddNode( outputNode.GetPointer() );
+  vtkNew<vtkMRMLTransformSmootherNode> tsNode;
+  scene->AddNode( tsNode.GetPointer() );
+  tsNode->SetAndObserveInputTransformNodeID( inputNode->GetID() );
+  tsNode->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+  tsNode->SetFilterMode( std::max( 0, filterMode ) );
+  tsNode->SetFilterActivated( filterMode >= 0 );
+
+  // Samples are filtered with their synthetic timestamps, not when the input node is modified
+  inputNode->SetDisableModifiedEvent( 1 );
+
+  // Input matrices are prepared and outputs collected outside of the timed loop
+  const int numberOfSamples = static_cast<int>( stream.Timestamps.size() );
+  std::vector< vtkSmartPointer<vtkMatrix4x4> > inputMatrices( numberOfSamples );
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    double rotation[4];
+    double translation[3];
+    stream.Samples.GetPose( i, rotation, translation );
+    inputMatrices[i] = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSlicerTransformSmootherFilterBank::GetMatrixFromPose( rotation, translation, inputMatrices[i]->Element );
+    }
+  vtkSlicerTransformSmootherPoseArrays outputs;
+  outputs.Resize( numberOfSamples );
+  vtkNew<vtkMatrix4x4> outputMatrix;
+
+  const double start = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    inputNode->SetMatrixTransformToParent( inputMatrices[i] );
+    logic->Filter( tsNode.GetPointer(), stream.Timestamps[i] );
+    outputNode->GetMatrixTransformToParent( outputMatrix.GetPointer() );
+    double rotation[4];
+    double translation[3];
+    vtkSlicerTransformSmootherFilterBank::GetPoseFromMatrix( outputMatrix->Element, rotation, translation );
+    outputs.SetPose( i, rotation, translation );
+    }
+  const double seconds = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp() - start;
+
+  ReplayResult result;
+  result.StreamName = stream.Name;
+  result.FilterName = ( filterMode >= 0 ) ? vtkMRMLTransformSmootherNode::GetFilterModeAsString( filterMode ) : "None";
+  result.NumberOfSamples = numberOfSamples;
+  result.SamplesPerSecond = ( seconds > 0.0 ) ? numberOfSamples / seconds : 0.0;
+  result.RmsTranslationError = 0.0;
+  result.MaximumTranslationError = 0.0;
+  result.RmsRotationError = 0.0;
+  result.MaximumRotationError = 0.0;
+  int numberOfComparedSamples = 0;
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    if ( stream.Timestamps[i] - stream.Timestamps[0] < WarmUpTime )
+      {
+      continue;
+      }
+    double rotation[4];
+    double translation[3];
+    double trueRotation[4];
+    double trueTranslation[3];
+    outputs.GetPose( i, rotation, translation );
+    stream.GroundTruth.GetPose( i, trueRotation, trueTranslation );
+    const double translationError = sqrt( vtkMath::Distance2BetweenPoints( translation, trueTranslation ) );
+    const double dot = fabs( rotation[0] * trueRotation[0] + rotation[1] * trueRotation[1]
+      + rotation[2] * trueRotation[2] + rotation[3] * trueRotation[3] );
+    const double rotationError = vtkMath::DegreesFromRadians( 2.0 * acos( std::min( 1.0, dot ) ) );
+    result.RmsTranslationError += translationError * translationError;
+    result.RmsRotationError += rotationError * rotationError;
+    result.MaximumTranslationError = std::max( result.MaximumTranslationError, translationError );
+    result.MaximumRotationError = std::max( result.MaximumRotationError, rotationError );
+    ++numberOfComparedSamples;
+    }
+  if ( numberOfComparedSamples > 0 )
+    {
+    result.RmsTranslationError = sqrt( result.RmsTranslationError / numberOfComparedSamples );
+    result.RmsRotationError = sqrt( result.RmsRotationError / numberOfComparedSamples );
+    }
+
+  std::cerr << result.StreamName << "/" << result.FilterName << ": "
+            << result.SamplesPerSecond << " samples/s, RMS error "
+            << result.RmsTranslationError << " mm, " << result.RmsRotationError << " deg" << std::endl;
+  logic->SetMRMLScene( NULL );
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+void WriteResults(std::ostream& os, const ReplayOptions& options, const std::vector<ReplayResult>& results)
+{
+  os << "{" << std::endl;
+  os << "  \"rate\": " << options.Rate << "," << std::endl;
+  os << "  \"noise\": " << options.Noise << "," << std::endl;
+  os << "  \"rotationNoise\": " << options.RotationNoise << "," << std::endl;
+  os << "  \"jitter\": " << options.Jitter << "," << std::endl;
+  os << "  \"seed\": " << options.Seed << "," << std::endl;
+  os << "  \"results\": [" << std::endl;
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+    const ReplayResult& result = results[i];
+    os << "    {"
+       << " \"stream\": \"" << result.StreamName << "\","
+       << " \"filter\": \"" << result.FilterName << "\","
+       << " \"samples\": " << result.NumberOfSamples << ","
+       << " \"samplesPerSecond\": " << result.SamplesPerSecond << ","
+       << " \"rmsTranslationError\": " << result.RmsTranslationError << ","
+       << " \"maxTranslationError\": " << result.MaximumTranslationError << ","
+       << " \"rmsRotationError\": " << result.RmsRotationError << ","
+       << " \"maxRotationError\": " << result.MaximumRotationError
+       << " }" << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+    }
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+bool ParseArguments(int argc, char* argv[], ReplayOptions& options)
+{
+  for (int i = 1; i < argc; ++i)
+    {
+    const bool hasValue = ( i + 1 < argc );
+    if ( !strcmp( argv[i], "--motion" ) && hasValue )
+      {
+      ++i;
+      options.Motion = -1;
+      for (int motion = 0; motion < NumberOfMotions; ++motion)
+        {
+        options.Motion = strcmp( argv[i], MotionNames[motion] ) ? options.Motion : motion;
+        }
+      if ( options.Motion < 0 )
+        {
+        return false;
+        }
+      }
+    else if ( !strcmp( argv[i], "--mode" ) && hasValue )
+      {
+      options.FilterMode = vtkMRMLTransformSmootherNode::GetFilterModeFromString( argv[++i] );
+      if ( options.FilterMode < 0 )
+        {
+        return false;
+        }
+      }
+    else if ( !strcmp( argv[i], "--rate" ) && hasValue )
+      {
+      options.Rate = atof( argv[++i] );
+      }
+    else if ( !strcmp( argv[i], "--duration" ) && hasValue )
+      {
+      options.Duration = atof( argv[++i] );
+      }
+    else if ( !strcmp( argv[i], "--noise" ) && hasValue )
+      {
+      options.Noise = atof( argv[++i] );
+      }
+    else if ( !strcmp( argv[i], "--rotation-noise" ) && hasValue )
+      {
+      options.RotationNoise = atof( argv[++i] );
+      }
+    else if ( !strcmp( argv[i], "--jitter" ) && hasValue )
+      {
+      options.Jitter = atof( argv[++i] );
+      }
+    else if ( !strcmp( argv[i], "--seed" ) && hasValue )
+      {
+      options.Seed = static_cast<unsigned int>( atoi( argv[++i] ) );
+      }
+    else if ( !strcmp( argv[i], "--trajectory" ) && hasValue )
+      {
+      options.TrajectoryFileName = argv[++i];
+      }
+    else if ( !strcmp( argv[i], "--max-translation-error" ) && hasValue )
+      {
+      options.MaximumTranslationError = atof( argv[++i] );
+      }
+    else if ( !strcmp( argv[i], "--max-rotation-error" ) && hasValue )
+      {
+      options.MaximumRotationError = atof( argv[++i] );
+      }
+    else if ( !strcmp( argv[i], "--output" ) && hasValue )
+      {
+      options.OutputFileName = argv[++i];
+      }
+    else
+      {
+      return false;
+      }
+    }
+  return options.Rate > 0.0 && options.Duration > 0.0;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  ReplayOptions options;
+  if ( !ParseArguments( argc, argv, options ) )
+    {
+    std::cerr << "Usage: " << argv[0] << " [--motion name] [--mode name] [--rate Hz] [--duration s]"
+              << " [--noise mm] [--rotation-noise deg] [--jitter s] [--seed N] [--trajectory file]"
+              << " [--max-translation-error mm] [--max-rotation-error deg] [--output results.json]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::vector<PoseStream> streams;
+  if ( options.TrajectoryFileName != NULL )
+    {
+    if ( !MakeTrajectoryStream( options.TrajectoryFileName, streams ) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  else
+    {
+    MakeScriptedStreams( options, streams );
+    }
+
+  std::vector<ReplayResult> results;
+  bool success = true;
+  for (size_t s = 0; s < streams.size(); ++s)
+    {
+    // Unfiltered samples are the reference for the improvement brought by the filters
+    results.push_back( Replay( streams[s], -1 ) );
+    for (int filterMode = 0; filterMode < vtkMRMLTransformSmootherNode::FilterMode_Last; ++filterMode)
+      {
+      if ( options.FilterMode >= 0 && filterMode != options.FilterMode )
+        {
+        continue;
+        }
+      const ReplayResult result = Replay( streams[s], filterMode );
+      if ( ( options.MaximumTranslationError >= 0.0 && result.RmsTranslationError > options.MaximumTranslationError )
+        || ( options.MaximumRotationError >= 0.0 && result.RmsRotationError > options.MaximumRotationError ) )
+        {
+        std::cerr << result.StreamName << "/" << result.FilterName << ": RMS error exceeds the maximum" << std::endl;
+        success = false;
+        }
+      results.push_back( result );
+      }
+    }
+
+  if ( options.OutputFileName == NULL )
+    {
+    WriteResults( std::cout, options, results );
+    }
+  else
+    {
+    std::ofstream output( options.OutputFileName );
+    if ( !output )
+      {
+      std::cerr << "Cannot write " << options.OutputFileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    WriteResults( output, options, results );
+    }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
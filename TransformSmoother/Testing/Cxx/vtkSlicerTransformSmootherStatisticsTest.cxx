@@ -0,0 +1,164 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherLogic.h"
+#include "vtkSlicerTransformSmootherStatistics.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Percentiles must be within the bin width (about 20%) of the exact value
+bool CheckPercentile(const char* name, double percentile, double expected)
+{
+  if ( fabs( percentile - expected ) > 0.2 * expected )
+    {
+    std::cerr << name << ": expected " << expected << ", got " << percentile << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool TestHistogram()
+{
+  // 1 us to 1 ms in 1 us steps
+  vtkSlicerTransformSmootherStatistics statistics;
+  for (int i = 1; i <= 1000; ++i)
+    {
+    statistics.AddProcessedSample( i * 1e-6, 2.0 * i * 1e-3 );
+    }
+  statistics.AddDroppedSample();
+
+  if ( statistics.GetNumberOfProcessedSamples() != 1000 || statistics.GetNumberOfDroppedSamples() != 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong sample counts" << std::endl;
+    return false;
+    }
+  if ( !CheckPercentile( "Filter time p50", statistics.GetFilterTimePercentile( 0.5 ), 500e-6 )
+    || !CheckPercentile( "Filter time p99", statistics.GetFilterTimePercentile( 0.99 ), 990e-6 )
+    || !CheckPercentile( "Latency p50", statistics.GetLatencyPercentile( 0.5 ), 1.0 )
+    || !CheckPercentile( "Latency p99", statistics.GetLatencyPercentile( 0.99 ), 1.98 ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong percentiles" << std::endl;
+    return false;
+    }
+
+  statistics.Reset();
+  if ( statistics.GetNumberOfProcessedSamples() != 0 || statistics.GetFilterTimePercentile( 0.5 ) != 0.0 )
+    {
+    std::cerr << "Line " << __LINE__ << ": statistics not reset" << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherStatisticsTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  if ( !TestHistogram() )
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformSmootherLogic> logic;
+  logic->SetMRMLScene( scene.GetPointer() );
+
+  vtkNew<vtkMRMLLinearTransformNode> inputNode;
+  scene->AddNode( inputNode.GetPointer() );
+  vtkNew<vtkMRMLLinearTransformNode> outputNode;
+  scene->AddNode( outputNode.GetPointer() );
+
+  vtkNew<vtkMRMLTransformSmootherNode> tsNode;
+  scene->AddNode( tsNode.GetPointer() );
+  tsNode->SetAndObserveInputTransformNodeID( inputNode->GetID() );
+  tsNode->SetAndObserveFilteredTransformNodeID( outputNode->GetID() );
+  tsNode->FilterActivatedOn();
+
+  // Statistics are off by default
+  const double samplingPeriod = 0.004;
+  double timestamp = vtkSlicerTransformSmootherLogic::GetCurrentTimestamp();
+  for (int i = 0; i < 10; ++i, timestamp += samplingPeriod)
+    {
+    logic->Filter( tsNode.GetPointer(), timestamp );
+    }
+  if ( tsNode->GetStatistics().GetNumberOfProcessedSamples() != 0 )
+    {
+    std::cerr << "Line " << __LINE__ << ": statistics collected while disabled" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // 100 samples, then one sample with the same timestamp as the previous one, which is dropped
+  tsNode->StatisticsEnabledOn();
+  for (int i = 0; i < 100; ++i, timestamp += samplingPeriod)
+    {
+    logic->Filter( tsNode.GetPointer(), timestamp );
+    }
+  logic->Filter( tsNode.GetPointer(), timestamp - samplingPeriod );
+
+  const vtkSlicerTransformSmootherStatistics& statistics = tsNode->GetStatistics();
+  if ( statistics.GetNumberOfProcessedSamples() != 100 || statistics.GetNumberOfDroppedSamples() != 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected 100 processed and 1 dropped samples, got "
+              << statistics.GetNumberOfProcessedSamples() << " and "
+              << statistics.GetNumberOfDroppedSamples() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( statistics.GetFilterTimePercentile( 0.99 ) <= 0.0
+    || statistics.GetFilterTimePercentile( 0.5 ) > statistics.GetFilterTimePercentile( 0.99 ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": invalid filter time percentiles" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // FilterAll only filters an input modified since its last sample, even without modified event
+  inputNode->SetDisableModifiedEvent( 1 );
+  for (int i = 0; i < 10; ++i, timestamp += samplingPeriod)
+    {
+    if ( i == 5 )
+      {
+      vtkNew<vtkMatrix4x4> inputMatrix;
+      inputMatrix->SetElement( 0, 3, 1.0 );
+      inputNode->SetMatrixTransformToParent( inputMatrix.GetPointer() );
+      }
+    logic->FilterAll( timestamp );
+    }
+  if ( statistics.GetNumberOfProcessedSamples() != 101 || statistics.GetNumberOfDroppedSamples() != 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected 101 processed and 1 dropped samples after FilterAll, got "
+              << statistics.GetNumberOfProcessedSamples() << " and "
+              << statistics.GetNumberOfDroppedSamples() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
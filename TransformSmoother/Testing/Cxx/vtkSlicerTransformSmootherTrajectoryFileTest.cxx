@@ -0,0 +1,163 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherTrajectoryReader.h"
+#include "vtkSlicerTransformSmootherTrajectoryWriter.h"
+
+// STD includes
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+void GetSample(int index, double& timestamp, double rotation[4], double translation[3])
+{
+  const double angle = 0.001 * index;
+  timestamp = 0.004 * index;
+  rotation[0] = cos( angle / 2.0 );
+  rotation[1] = sin( angle / 2.0 );
+  rotation[2] = 0.0;
+  rotation[3] = 0.0;
+  translation[0] = 0.1 * index;
+  translation[1] = -0.2 * index;
+  translation[2] = 1000.0 + index;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckSamples(vtkSlicerTransformSmootherTrajectoryReader& reader, int numberOfSamples)
+{
+  if ( reader.GetNumberOfRecords() != static_cast<vtkTypeUInt64>( numberOfSamples ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << numberOfSamples << " records, got "
+              << reader.GetNumberOfRecords() << std::endl;
+    return false;
+    }
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    double expectedTimestamp = 0.0;
+    double expectedRotation[4];
+    double expectedTranslation[3];
+    GetSample( i, expectedTimestamp, expectedRotation, expectedTranslation );
+    double timestamp = 0.0;
+    double rotation[4];
+    double translation[3];
+    reader.GetSample( i, timestamp, rotation, translation );
+    // Values are stored as is, they must be identical
+    if ( timestamp != expectedTimestamp
+      || rotation[0] != expectedRotation[0] || rotation[1] != expectedRotation[1]
+      || rotation[2] != expectedRotation[2] || rotation[3] != expectedRotation[3]
+      || translation[0] != expectedTranslation[0] || translation[1] != expectedTranslation[1]
+      || translation[2] != expectedTranslation[2]
+      || reader.GetRecords()[i].Timestamp != expectedTimestamp )
+      {
+      std::cerr << "Line " << __LINE__ << ": record " << i << " differs from the recorded sample" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherTrajectoryFileTest(int argc, char* argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " temporary_directory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string filename = std::string( argv[1] ) + "/vtkSlicerTransformSmootherTrajectoryFileTest.bin";
+
+  // More samples than the writer buffers at once
+  const int numberOfSamples = 40000;
+  vtkSlicerTransformSmootherTrajectoryWriter writer;
+  if ( !writer.Open( filename.c_str() ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": cannot create " << filename << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 0; i < numberOfSamples; ++i)
+    {
+    double timestamp = 0.0;
+    double rotation[4];
+    double translation[3];
+    GetSample( i, timestamp, rotation, translation );
+    if ( !writer.WriteSample( timestamp, rotation, translation ) )
+      {
+      std::cerr << "Line " << __LINE__ << ": cannot write sample " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if ( !writer.Close() )
+    {
+    std::cerr << "Line " << __LINE__ << ": cannot close " << filename << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkSlicerTransformSmootherTrajectoryReader reader;
+  if ( !reader.Open( filename.c_str() ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": cannot read " << filename << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( !CheckSamples( reader, numberOfSamples ) )
+    {
+    return EXIT_FAILURE;
+    }
+  reader.Close();
+
+  // Interrupted recording: the header has no record count and the last record is incomplete
+  FILE* file = fopen( filename.c_str(), "r+b" );
+  vtkSlicerTransformSmootherTrajectoryFormat::Header header;
+  if ( file == NULL || fread( &header, sizeof( header ), 1, file ) != 1 )
+    {
+    std::cerr << "Line " << __LINE__ << ": cannot modify " << filename << std::endl;
+    return EXIT_FAILURE;
+    }
+  header.NumberOfRecords = 0;
+  const char partialRecord[10] = { 0 };
+  fseek( file, 0, SEEK_SET );
+  fwrite( &header, sizeof( header ), 1, file );
+  fseek( file, 0, SEEK_END );
+  fwrite( partialRecord, sizeof( partialRecord ), 1, file );
+  fclose( file );
+  if ( !reader.Open( filename.c_str() ) || !CheckSamples( reader, numberOfSamples ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": records of an interrupted recording are not read" << std::endl;
+    return EXIT_FAILURE;
+    }
+  reader.Close();
+
+  // Other files are rejected
+  file = fopen( filename.c_str(), "wb" );
+  header.Magic[0] = 'X';
+  fwrite( &header, sizeof( header ), 1, file );
+  fclose( file );
+  if ( reader.Open( filename.c_str() ) )
+    {
+    std::cerr << "Line " << __LINE__ << ": file that is not a trajectory file is read" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  remove( filename.c_str() );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// TransformSmoother includes
+#include "vtkSlicerTransformSmootherZeroPhaseSmoother.h"
+
+// VTK includes
+#include <vtkSetGet.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+const double SpeedMmPerSecond = 50.0;
+
+//-----------------------------------------------------------------------------
+// Simulated tracker sample with jitter: translation at constant speed along x and
+// rotation oscillating around z, slightly irregular sampling at 250 Hz
+void GetSample(int index, double& timestamp, double rotation[4], double translation[3])
+{
+  timestamp = index * 0.004 + 0.0005 * ( index % 3 );
+  const double angle = 0.3 * sin( 2.0 * timestamp ) + 0.002 * ( ( index * 7 ) % 5 - 2 );
+  rotation[0] = cos( angle / 2.0 );
+  rotation[1] = 0.0;
+  rotation[2] = 0.0;
+  rotation[3] = sin( angle / 2.0 );
+  translation[0] = SpeedMmPerSecond * timestamp + 0.1 * ( ( index * 13 ) % 7 - 3 );
+  translation[1] = 10.0 * sin( timestamp );
+  translation[2] = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+// Smooth numberOfSamples samples, retrieving smoothed samples as soon as they are available.
+// Stores the x translation and z rotation component of each smoothed sample.
+bool Smooth(int numberOfSamples, int chunkSize, std::vector<double>& smoothed)
+{
+  vtkSlicerTransformSmootherZeroPhaseSmoother smoother;
+  smoother.SetCutOffFrequency( 5.0 );
+  smoother.SetChunkSize( chunkSize );
+
+  smoothed.clear();
+  double timestamp = 0.0;
+  double rotation[4];
+  double translation[3];
+  int numberOfSmoothedSamples = 0;
+  for (int i = 0; i <= numberOfSamples; ++i)
+    {
+    if ( i < numberOfSamples )
+      {
+      GetSample( i, timestamp, rotation, translation );
+      smoother.AddSample( timestamp, rotation, translation );
+      }
+    else
+      {
+      smoother.Finish();
+      }
+    double smoothedTimestamp = 0.0;
+    while ( smoother.PopSample( smoothedTimestamp, rotation, translation ) )
+      {
+      double expectedTimestamp = 0.0;
+      double sampleRotation[4];
+      double sampleTranslation[3];
+      GetSample( numberOfSmoothedSamples++, expectedTimestamp, sampleRotation, sampleTranslation );
+      if ( smoothedTimestamp != expectedTimestamp )
+        {
+        std::cerr << "Line " << __LINE__ << ": smoothed samples out of order" << std::endl;
+        return false;
+        }
+      smoothed.push_back( translation[0] );
+      smoothed.push_back( rotation[3] );
+      }
+    }
+  if ( numberOfSmoothedSamples != numberOfSamples )
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << numberOfSamples << " smoothed samples, got "
+              << numberOfSmoothedSamples << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformSmootherZeroPhaseSmootherTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const int numberOfSamples = 20000;
+
+  // Whole trajectory in a single chunk: exact forward-backward filtering
+  std::vector<double> exact;
+  if ( !Smooth( numberOfSamples, numberOfSamples, exact ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Zero phase: no lag on the constant speed translation (a causal low-pass filter lags by
+  // about speed / cutoff), away from the ends of the trajectory
+  double meanError = 0.0;
+  for (int i = 1000; i < numberOfSamples - 1000; ++i)
+    {
+    double timestamp = 0.0;
+    double rotation[4];
+    double translation[3];
+    GetSample( i, timestamp, rotation, translation );
+    meanError += exact[2 * i] - SpeedMmPerSecond * timestamp;
+    }
+  meanError /= numberOfSamples - 2000;
+  if ( fabs( meanError ) > 0.01 )
+    {
+    std::cerr << "Line " << __LINE__ << ": smoothed translation lags by " << meanError << " mm" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Streaming by small chunks must give the same result up to the truncation tolerance
+  std::vector<double> chunked;
+  if ( !Smooth( numberOfSamples, 256, chunked ) )
+    {
+    return EXIT_FAILURE;
+    }
+  for (size_t i = 0; i < exact.size(); ++i)
+    {
+    if ( fabs( chunked[i] - exact[i] ) > 1e-4 )
+      {
+      std::cerr << "Line " << __LINE__ << ": chunked smoothing differs from exact smoothing by "
+                << chunked[i] - exact[i] << " at sample " << i / 2 << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -16,11 +16,15 @@
 ==============================================================================*/
 
 // Qt includes
+#include <QTimer>
 #include <QtPlugin>
 
 // TransformSmoother Logic includes
 #include <vtkSlicerTransformSmootherLogic.h>
 
+// VTK includes
+#include <vtkCommand.h>
+
 // TransformSmoother includes
 #include "qSlicerTransformSmootherModule.h"
 #include "qSlicerTransformSmootherModuleWidget.h"
@@ -34,6 +38,9 @@ class qSlicerTransformSmootherModulePrivate
 {
 public:
   qSlicerTransformSmootherModulePrivate();
+
+  /// Writes the transforms filtered in the background to the scene
+  QTimer PublishTimer;
 };
 
 //-----------------------------------------------------------------------------
@@ -100,7 +107,52 @@ QStringList qSlicerTransformSmootherModule::dependencies() const
 //-----------------------------------------------------------------------------
 void qSlicerTransformSmootherModule::setup()
 {
+  Q_D(qSlicerTransformSmootherModule);
   this->Superclass::setup();
+
+  // Filtered transforms computed by the background worker of the logic must be
+  // written to the scene on the main thread. The timer only runs while background
+  // filtering is enabled, which the logic reports by a modified event.
+  d->PublishTimer.setInterval( 5 );
+  connect( &d->PublishTimer, SIGNAL(timeout()),
+           this, SLOT(publishFilteredTransforms()) );
+  qvtkConnect( this->logic(), vtkCommand::ModifiedEvent,
+               this, SLOT(updatePublishTimer()) );
+  // Fused outputs of the samples filtered in an event loop iteration are written once, at its end
+  qvtkConnect( this->logic(), vtkSlicerTransformSmootherLogic::FusedOutputsPendingEvent,
+               this, SLOT(schedulePublishFilteredTransforms()) );
+  this->updatePublishTimer();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformSmootherModule::schedulePublishFilteredTransforms()
+{
+  QTimer::singleShot( 0, this, SLOT(publishFilteredTransforms()) );
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformSmootherModule::updatePublishTimer()
+{
+  Q_D(qSlicerTransformSmootherModule);
+  vtkSlicerTransformSmootherLogic* logic = vtkSlicerTransformSmootherLogic::SafeDownCast( this->logic() );
+  if ( logic == NULL || !logic->GetBackgroundFiltering() )
+    {
+    d->PublishTimer.stop();
+    }
+  else if ( !d->PublishTimer.isActive() )
+    {
+    d->PublishTimer.start();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformSmootherModule::publishFilteredTransforms()
+{
+  vtkSlicerTransformSmootherLogic* logic = vtkSlicerTransformSmootherLogic::SafeDownCast( this->logic() );
+  if ( logic != NULL )
+    {
+    logic->PublishFilteredTransforms();
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -21,6 +21,9 @@
 // SlicerQt includes
 #include "qSlicerLoadableModule.h"
 
+// CTK includes
+#include <ctkVTKObject.h>
+
 #include "qSlicerTransformSmootherModuleExport.h"
 
 class qSlicerTransformSmootherModulePrivate;
@@ -31,6 +34,7 @@ qSlicerTransformSmootherModule
   : public qSlicerLoadableModule
 {
   Q_OBJECT
+  QVTK_OBJECT
   Q_INTERFACES(qSlicerLoadableModule);
 
 public:
@@ -61,6 +65,17 @@ protected:
   /// Create and return the logic associated to this module
   virtual vtkMRMLAbstractLogic* createLogic();
 
+protected slots:
+
+  /// Write the transforms filtered by the background worker of the logic to the scene
+  void publishFilteredTransforms();
+
+  /// Run the publish timer only while background filtering of the logic is enabled
+  void updatePublishTimer();
+
+  /// Publish the filtered transforms once the pending events are processed
+  void schedulePublishFilteredTransforms();
+
 protected:
   QScopedPointer<qSlicerTransformSmootherModulePrivate> d_ptr;
 
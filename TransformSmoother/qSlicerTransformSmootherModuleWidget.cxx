@@ -18,7 +18,6 @@
 // Qt includes
 #include <QDebug>
 #include <QMessageBox>
-#include <QTimer>
 
 // SlicerQt includes
 #include "qSlicerTransformSmootherModuleWidget.h"
@@ -43,8 +42,6 @@ public:
   qSlicerTransformSmootherModuleWidgetPrivate( qSlicerTransformSmootherModuleWidget& object );
   ~qSlicerTransformSmootherModuleWidgetPrivate();
   vtkSlicerTransformSmootherLogic* logic() const;
-
-  QTimer* UpdatingTransformTimer;
 };
 
 //-----------------------------------------------------------------------------
@@ -53,17 +50,11 @@ public:
 //-----------------------------------------------------------------------------
 qSlicerTransformSmootherModuleWidgetPrivate::qSlicerTransformSmootherModuleWidgetPrivate( qSlicerTransformSmootherModuleWidget& object ) : q_ptr( &object )
 {
-  this->UpdatingTransformTimer = new QTimer();
 }
 
 //-----------------------------------------------------------------------------
 qSlicerTransformSmootherModuleWidgetPrivate::~qSlicerTransformSmootherModuleWidgetPrivate()
 {
-  if (this->UpdatingTransformTimer)
-    {
-    this->UpdatingTransformTimer->stop();
-    this->UpdatingTransformTimer->deleteLater();
-    }
 }
 
 //-----------------------------------------------------------------------------
@@ -100,9 +91,6 @@ void qSlicerTransformSmootherModuleWidget::setup()
   connect(d->ModuleNodeComboBox, SIGNAL(currentNodeChanged(vtkMRMLNode*)),
 	  this, SLOT(onModuleNodeChanged()));
 
-  connect(d->UpdatingTransformTimer, SIGNAL(timeout()),
-	  this, SLOT(onUpdatingTransformTimeout()));
-
   connect(d->ActivateFilterCheckBox, SIGNAL(toggled(bool)),
 	  this, SLOT(onFilterToggled(bool)));
 
@@ -151,12 +139,6 @@ void qSlicerTransformSmootherModuleWidget::enter()
     d->ModuleNodeComboBox->setCurrentNodeID( node->GetID() );
     }
 
-  // Start timer if not already started
-  if ( d->UpdatingTransformTimer->isActive() == false )
-    {
-    d->UpdatingTransformTimer->start( 50 );
-    }
-
   this->Superclass::enter();
 }
 
@@ -182,32 +164,6 @@ void qSlicerTransformSmootherModuleWidget::onModuleNodeChanged()
   this->UpdateFromMRMLNode();
 }
 
-//-----------------------------------------------------------------------------
-void qSlicerTransformSmootherModuleWidget::onUpdatingTransformTimeout()
-{
-  Q_D(qSlicerTransformSmootherModuleWidget);
-
-  if ( this->mrmlScene() == NULL )
-    {
-    return;
-    }
-
-  vtkCollection* filteringNodes = this->mrmlScene()->GetNodesByClass( "vtkMRMLTransformSmootherNode" );
-  for (int i = 0; i < filteringNodes->GetNumberOfItems(); ++i)
-    {
-    vtkMRMLTransformSmootherNode* tsNode =
-      vtkMRMLTransformSmootherNode::SafeDownCast( filteringNodes->GetItemAsObject(i) );
-    if ( tsNode == NULL )
-      {
-      return;
-      }
-
-    d->logic()->Filter( tsNode );
-    }
-
-  filteringNodes->Delete();
-}
-
 //-----------------------------------------------------------------------------
 void qSlicerTransformSmootherModuleWidget::onFilterToggled(bool filterActivated)
 {
@@ -259,7 +215,8 @@ void qSlicerTransformSmootherModuleWidget::onOutputNodeChanged()
     vtkMRMLLinearTransformNode::SafeDownCast( d->OutputTransformComboBox->currentNode() );
 
   // Sanity check: If the output transform is already selected as output in another filter
-  // with a different input, the output results will be the average of both inputs.
+  // with a different input, the output is the weighted average of the filtered transforms
+  // of both filters (see vtkMRMLTransformSmootherNode::SetFusionWeight).
   // User should be warned in this case.
 
   bool differentFiltersUsingSameOutput = false;
@@ -282,7 +239,7 @@ void qSlicerTransformSmootherModuleWidget::onOutputNodeChanged()
 
       QMessageBox warningMsg;
       std::stringstream ss;
-      ss << "Another filter (ID: " << tmpNode->GetID() << ") has been found in the scene with the same output transform. Having two or more filters with the same output will result in the average of all inputs of these filters. Are you sure you want to select this transform as output for this filter ?";
+      ss << "Another filter (ID: " << tmpNode->GetID() << ") has been found in the scene with the same output transform. Having two or more filters with the same output will write the weighted average of the filtered transforms of these filters (weighted by their fusion weight, written once per update with the latest filtered transform of each filter). Are you sure you want to select this transform as output for this filter ?";
       warningMsg.setText( ss.str().c_str() );
       warningMsg.setStandardButtons( QMessageBox::Yes | QMessageBox::No );
       warningMsg.setDefaultButton( QMessageBox::No );
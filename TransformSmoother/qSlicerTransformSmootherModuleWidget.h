@@ -48,7 +48,6 @@ protected slots:
 
   void onModuleNodeChanged();
 
-  void onUpdatingTransformTimeout();
   void onFilterToggled(bool filter);
   void onInputNodeChanged();
   void onOutputNodeChanged();